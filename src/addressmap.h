@@ -0,0 +1,163 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#ifndef _ADDRESS_MAP_H_
+#define _ADDRESS_MAP_H_
+
+#include "common.h"
+
+namespace SyntenyFinder
+{
+	//Hash map from non-null addresses to small values. It is an open addressing
+	//table with linear probing, so inserting and erasing call the heap only when
+	//the table grows past the largest size it has ever had.
+	template<class Value>
+		class AddressMap
+		{
+		public:
+			AddressMap(): size_(0), shift_(0) {}
+
+			size_t Size() const
+			{
+				return size_;
+			}
+
+			void Clear()
+			{
+				std::fill(key_.begin(), key_.end(), static_cast<const void*>(0));
+				size_ = 0;
+			}
+
+			void Reserve(size_t size)
+			{
+				if(size * 2 > key_.size())
+				{
+					size_t capacity = MIN_CAPACITY;
+					for(; capacity < size * 2; capacity *= 2);
+					Rehash(capacity);
+				}
+			}
+
+			//Returns 0 if there is no such key
+			const Value * Find(const void * key) const
+			{
+				assert(key != 0);
+				if(size_ > 0)
+				{
+					for(size_t i = Home(key); key_[i] != 0; i = Next(i))
+					{
+						if(key_[i] == key)
+						{
+							return &value_[i];
+						}
+					}
+				}
+
+				return 0;
+			}
+
+			//The key must not be in the map
+			void Insert(const void * key, Value value)
+			{
+				assert(key != 0 && Find(key) == 0);
+				Reserve(size_ + 1);
+				size_t i = Home(key);
+				for(; key_[i] != 0; i = Next(i));
+				key_[i] = key;
+				value_[i] = value;
+				size_++;
+			}
+
+			bool Erase(const void * key, Value & value)
+			{
+				assert(key != 0);
+				if(size_ == 0)
+				{
+					return false;
+				}
+
+				size_t i = Home(key);
+				for(; key_[i] != key; i = Next(i))
+				{
+					if(key_[i] == 0)
+					{
+						return false;
+					}
+				}
+
+				value = value_[i];
+				//Shift back the following keys of the run that can't be found otherwise
+				for(size_t j = Next(i); key_[j] != 0; j = Next(j))
+				{
+					size_t home = Home(key_[j]);
+					if((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j))
+					{
+						key_[i] = key_[j];
+						value_[i] = value_[j];
+						i = j;
+					}
+				}
+
+				key_[i] = 0;
+				size_--;
+				return true;
+			}
+
+			//Cells are for the traversal, an empty cell has a null key
+			size_t GetCapacity() const
+			{
+				return key_.size();
+			}
+
+			const void * GetKey(size_t cell) const
+			{
+				return key_[cell];
+			}
+
+			Value GetValue(size_t cell) const
+			{
+				return value_[cell];
+			}
+
+		private:
+			static const size_t MIN_CAPACITY = 16;
+			size_t size_;
+			size_t shift_;
+			std::vector<const void*> key_;
+			std::vector<Value> value_;
+
+			size_t Home(const void * key) const
+			{
+				return static_cast<size_t>((static_cast<uint64_t>(reinterpret_cast<size_t>(key)) * 0x9E3779B97F4A7C15ULL) >> shift_);
+			}
+
+			size_t Next(size_t cell) const
+			{
+				return (cell + 1) & (key_.size() - 1);
+			}
+
+			void Rehash(size_t capacity)
+			{
+				std::vector<const void*> oldKey(capacity, static_cast<const void*>(0));
+				std::vector<Value> oldValue(capacity);
+				oldKey.swap(key_);
+				oldValue.swap(value_);
+				for(shift_ = 64; (size_t(1) << (64 - shift_)) < capacity; shift_--);
+				for(size_t i = 0; i < oldKey.size(); i++)
+				{
+					if(oldKey[i] != 0)
+					{
+						size_t j = Home(oldKey[i]);
+						for(; key_[j] != 0; j = Next(j));
+						key_[j] = oldKey[i];
+						value_[j] = oldValue[i];
+					}
+				}
+			}
+		};
+}
+
+#endif
@@ -5,39 +5,58 @@
 //****************************************************************************
 
 #include "bifurcationstorage.h"
+#include "runstats.h"
+
 namespace SyntenyFinder
 {
 	const size_t BifurcationStorage::POSITIVE_BIT = 0;
 	const size_t BifurcationStorage::NEGATIVE_BIT = 1;
 	const BifurcationStorage::BifurcationId BifurcationStorage::NO_BIFURCATION = -1;	
+	const BifurcationStorage::BifurcationId BifurcationStorage::REMOVED = -2;
+	const Size BifurcationStorage::NO_SLOT = -1;
 
 	namespace
 	{
-		template<class T>
-			bool PtrEqual(T * ptr1, T * ptr2)
-			{
-				return ptr1 != 0 && ptr2 != 0 && *ptr1 == *ptr2;
-			}
+		const DNASequence::DNACharacter * Address(BifurcationStorage::BaseIterator it)
+		{
+			return &(*it);
+		}
 	}
 	
 	bool BifurcationStorage::IteratorProxy::Valid() const
 	{
-		return (*ptr_).get_padding_int() != NO_BIFURCATION;
+		return storage_->slot_[strand_][slot_].get_padding_int() != NO_BIFURCATION;
 	}
 	
 	StrandIterator BifurcationStorage::IteratorProxy::operator*() const
 	{
-		return StrandIterator(*ptr_, direction_);
+		return StrandIterator(storage_->slot_[strand_][slot_], static_cast<DNASequence::Direction>(strand_));
 	}
 
 	void BifurcationStorage::Cleanup()
 	{
-		for(size_t i = 0; i < toClear_.size(); i++)
+		for(size_t strand = 0; strand < 2; strand++)
 		{
-			toClear_[i].first->erase(toClear_[i].second);
-		}
+			for(size_t i = 0; i < toClear_[strand].size(); i++)
+			{
+				Size slot = toClear_[strand][i].first;
+				BifurcationId bifId = toClear_[strand][i].second;
+				count_[strand][bifId]--;
+				if(slot < baseSize_[strand])
+				{
+					slot_[strand][slot].get_padding_int() = REMOVED;
+				}
+				else
+				{
+					Size * link = &head_[strand][bifId];
+					for(; *link != slot; link = &next_[strand][*link - baseSize_[strand]]);
+					*link = next_[strand][slot - baseSize_[strand]];
+					free_[strand].push_back(slot);
+				}
+			}
 
-		toClear_.clear();
+			toClear_[strand].clear();
+		}
 	}
 	
 	void BifurcationStorage::Clear()
@@ -45,16 +64,56 @@ namespace SyntenyFinder
 		maxId_ = 0;
 		for(size_t strand = 0; strand < 2; strand++)
 		{
-			posBifurcation_[strand].clear();
-			bifurcationPos_[strand].assign(maxId_ + 1, IteratorList());
+			baseSize_[strand] = 0;
+			slot_[strand].clear();
+			offset_[strand].assign(maxId_ + 2, 0);
+			head_[strand].assign(maxId_ + 1, NO_SLOT);
+			next_[strand].clear();
+			count_[strand].assign(maxId_ + 1, 0);
+			free_[strand].clear();
+			posSlot_[strand].Clear();
 		}
 	}
 	
-	BifurcationStorage::BifurcationStorage(size_t maxId): maxId_(static_cast<BifurcationId>(maxId))
+	BifurcationStorage::BifurcationStorage(size_t maxId): maxId_(static_cast<BifurcationId>(maxId)), nowInvalid_(0), invalidSize_(0)
 	{
 		for(size_t strand = 0; strand < 2; strand++)
 		{
-			bifurcationPos_[strand].assign(maxId_ + 1, IteratorList());
+			baseSize_[strand] = 0;
+			offset_[strand].assign(maxId_ + 2, 0);
+			head_[strand].assign(maxId_ + 1, NO_SLOT);
+			count_[strand].assign(maxId_ + 1, 0);
+		}
+	}
+
+	void BifurcationStorage::Load(DNASequence::Direction direction, const std::vector<BaseIterator> & point)
+	{
+		size_t strand = direction == DNASequence::positive ? 0 : 1;
+		assert(slot_[strand].empty());
+		std::vector<Size> & offset = offset_[strand];
+		for(size_t i = 0; i < point.size(); i++)
+		{
+			offset[point[i].get_padding_int() + 1]++;
+		}
+
+		for(size_t bifId = 0; bifId <= maxId_; bifId++)
+		{
+			count_[strand][bifId] = offset[bifId + 1];
+			offset[bifId + 1] += offset[bifId];
+		}
+
+		//The segments are filled from the last point, so later positions go first
+		std::vector<Size> fill(offset.begin(), offset.end() - 1);
+		baseSize_[strand] = static_cast<Size>(point.size());
+		slot_[strand].resize(point.size());
+		posSlot_[strand].Reserve(point.size());
+		for(size_t i = point.size(); i > 0; i--)
+		{
+			const BaseIterator & it = point[i - 1];
+			Size slot = fill[it.get_padding_int()]++;
+			slot_[strand][slot] = it;
+			StrandIterator(it, direction).SetInfoBit(strand, true);
+			posSlot_[strand].Insert(Address(it), slot);
 		}
 	}
 	
@@ -65,29 +124,30 @@ namespace SyntenyFinder
 
 	size_t BifurcationStorage::TotalElements() const
 	{
-		return bifurcationPos_[0].size() + bifurcationPos_[1].size();
+		return head_[0].size() + head_[1].size();
 	}
 
 	size_t BifurcationStorage::CountBifurcations(size_t inBifId) const
 	{
 		BifurcationId bifId = static_cast<BifurcationId>(inBifId);
-		return bifurcationPos_[0][bifId].size() + bifurcationPos_[1][bifId].size();
+		return count_[0][bifId] + count_[1][bifId];
 	}
 	
 	void BifurcationStorage::Dump(const DNASequence & sequence, size_t k, std::ostream & out) const
 	{
 		std::string strandName[] = {"Positive", "Negative"};
-		StrandIterator start[] = {sequence.PositiveBegin(0), sequence.NegativeBegin(0)};
 		for(size_t strand = 0; strand < 2; strand++)
 		{
 			out << strandName[strand] << ", bif:" ;
-			for(size_t bifId = 0; bifId < bifurcationPos_[strand].size(); bifId++)
+			for(size_t bifId = 0; bifId < head_[strand].size(); bifId++)
 			{
-				for(IteratorList::const_iterator it = bifurcationPos_[strand][bifId].begin(); it != bifurcationPos_[strand][bifId].end(); ++it)
+				std::vector<IteratorProxy> proxy;
+				ListPositions(bifId, std::back_inserter(proxy));
+				for(size_t i = 0; i < proxy.size(); i++)
 				{
-					if((*it).get_padding_int() != NO_BIFURCATION)
+					if(proxy[i].Valid() && (*proxy[i]).GetDirection() == static_cast<DNASequence::Direction>(strand))
 					{
-						StrandIterator jt(*it, static_cast<DNASequence::Direction>(strand));
+						StrandIterator jt = *proxy[i];
 						size_t pos = sequence.GlobalIndex(jt);
 						out << " {" << bifId << ", " << pos << ", ";
 						CopyN(jt, k, std::ostream_iterator<char>(out));
@@ -97,13 +157,17 @@ namespace SyntenyFinder
 			}
 			
 			out << std::endl << strandName[strand] << ", pos:" ;
-			for(IteratorMap::const_iterator it = posBifurcation_[strand].begin(); it != posBifurcation_[strand].end(); ++it)
+			for(size_t cell = 0; cell < posSlot_[strand].GetCapacity(); cell++)
 			{
-				StrandIterator jt(**it, static_cast<DNASequence::Direction>(strand));
-				size_t pos = sequence.GlobalIndex(jt);
-				out << " {" << pos << ", ";
-				CopyN(jt, k, std::ostream_iterator<char>(out));
-				out << ", " << (**it).get_padding_int() << "}";
+				if(posSlot_[strand].GetKey(cell) != 0)
+				{
+					Size slot = posSlot_[strand].GetValue(cell);
+					StrandIterator jt(slot_[strand][slot], static_cast<DNASequence::Direction>(strand));
+					size_t pos = sequence.GlobalIndex(jt);
+					out << " {" << pos << ", ";
+					CopyN(jt, k, std::ostream_iterator<char>(out));
+					out << ", " << slot_[strand][slot].get_padding_int() << "}";
+				}
 			}			
 
 			out << std::endl;
@@ -119,23 +183,36 @@ namespace SyntenyFinder
 			it.SetInfoBit(strand, true);
 			BaseIterator newIt = it.Base();
 			newIt.get_padding_int() = bifId;
-			IteratorPtr newPtr = bifurcationPos_[strand][bifId].insert(bifurcationPos_[strand][bifId].begin(), newIt);
-			posBifurcation_[strand].insert(newPtr);
+			Size slot;
+			if(free_[strand].empty())
+			{
+				slot = static_cast<Size>(slot_[strand].size());
+				slot_[strand].push_back(newIt);
+				next_[strand].push_back(NO_SLOT);
+			}
+			else
+			{
+				slot = free_[strand].back();
+				free_[strand].pop_back();
+				slot_[strand][slot] = newIt;
+			}
+
+			next_[strand][slot - baseSize_[strand]] = head_[strand][bifId];
+			head_[strand][bifId] = slot;
+			count_[strand][bifId]++;
+			posSlot_[strand].Insert(Address(newIt), slot);
 			assert(GetBifurcation(it) == bifId);
 		}
 	}
 
 	
-	BifurcationStorage::BifurcationId BifurcationStorage::ErasePointInternal(DNASequence::StrandIterator it, IteratorPtr & ret)
+	BifurcationStorage::BifurcationId BifurcationStorage::ErasePointInternal(DNASequence::StrandIterator it, Size & ret)
 	{				
 		BifurcationId bifId = NO_BIFURCATION;
 		size_t strand = it.GetDirection() == DNASequence::positive ? 0 : 1;
-		IteratorMap::iterator kt = LookUp(it);
-		if(kt != posBifurcation_[strand].end())
+		if(it.GetInfoBit(strand) && posSlot_[strand].Erase(Address(it.Base()), ret))
 		{
-			ret = *kt;
-			bifId = (**kt).get_padding_int();
-			posBifurcation_[strand].erase(kt);
+			bifId = slot_[strand][ret].get_padding_int();
 		}
 
 		return bifId;
@@ -143,36 +220,43 @@ namespace SyntenyFinder
 
 	void BifurcationStorage::ErasePoint(DNASequence::StrandIterator it)
 	{
-		IteratorPtr buf;
-		size_t bifId = ErasePointInternal(it, buf);
+		Size slot;
+		BifurcationId bifId = ErasePointInternal(it, slot);
 		if(bifId != NO_BIFURCATION)
 		{				
 			size_t strand = it.GetDirection() == DNASequence::positive ? 0 : 1;
 			it.SetInfoBit(strand, false);
-			(*buf).get_padding_int() = NO_BIFURCATION;
-			toClear_.push_back(std::make_pair(&bifurcationPos_[strand][bifId], buf));
+			slot_[strand][slot].get_padding_int() = NO_BIFURCATION;
+			toClear_[strand].push_back(std::make_pair(slot, bifId));
 		}
 	}
 	
 	size_t BifurcationStorage::GetBifurcation(DNASequence::StrandIterator it) const
 	{
+		IncrementCounter(GET_BIFURCATION_COUNTER);
 		size_t strand = it.GetDirection() == DNASequence::positive ? 0 : 1;		
-		IteratorMap::const_iterator kt = LookUp(it);
-		return kt == posBifurcation_[strand].end() ? NO_BIFURCATION : (**kt).get_padding_int();
+		const Size * slot = LookUp(it);
+		return slot == 0 ? NO_BIFURCATION : slot_[strand][*slot].get_padding_int();
 	}
 
 	void BifurcationStorage::NotifyBefore(StrandIterator begin, StrandIterator end)
 	{
 		size_t pos = 0;
 		nowInvalid_ = 0;
-		invalid_.push_back(std::vector<BifurcationRecord>());
+		if(invalidSize_ == invalid_.size())
+		{
+			invalid_.push_back(std::vector<BifurcationRecord>());
+		}
+
+		std::vector<BifurcationRecord> & record = invalid_[invalidSize_++];
+		record.clear();
 		for(StrandIterator it = begin; it != end; ++it, ++pos)
 		{			
-			IteratorPtr ret;
-			BifurcationId bifId = ErasePointInternal(it, ret);
+			Size slot;
+			BifurcationId bifId = ErasePointInternal(it, slot);
 			if(bifId != NO_BIFURCATION)
 			{
-				invalid_.back().push_back(BifurcationRecord(pos, ret, bifId));
+				record.push_back(BifurcationRecord(pos, slot, bifId));
 			}
 		}		
 	}
@@ -187,64 +271,45 @@ namespace SyntenyFinder
 			{
 				size_t strand = it.GetDirection() == DNASequence::positive ? 0 : 1;
 				BifurcationId bifId = invalid_[nowInvalid_][record].bifId;
-				IteratorPtr jt = invalid_[nowInvalid_][record].ptrIt;				
+				Size slot = invalid_[nowInvalid_][record].slot;
 				BaseIterator newIt = it.Base();
 				newIt.get_padding_int() = bifId;
-				*jt = newIt;
-				posBifurcation_[strand].insert(jt);
+				slot_[strand][slot] = newIt;
+				posSlot_[strand].Insert(Address(newIt), slot);
 				record++;
 			}
 		}
 
-		if(++nowInvalid_ == invalid_.size())
+		if(++nowInvalid_ == invalidSize_)
 		{
-			invalid_.clear();
+			invalidSize_ = 0;
 		}
 	}
 
 	void BifurcationStorage::FormDictionary(boost::unordered_map<std::string, size_t> & dict, size_t k) const
 	{
 		dict.clear();
-		for(size_t dir = 0; dir < 2; dir++)
+		for(size_t bifId = 0; bifId <= maxId_; bifId++)
 		{
-			DNASequence::Direction type = static_cast<DNASequence::Direction>(dir);
-			for(ListVector::const_iterator it = bifurcationPos_[dir].begin(); it != bifurcationPos_[dir].end(); ++it)
+			std::vector<IteratorProxy> proxy;
+			ListPositions(bifId, std::back_inserter(proxy));
+			for(size_t i = 0; i < proxy.size(); i++)
 			{
-				for(IteratorList::const_iterator jt = it->begin(); jt != it->end(); ++jt)
-				{
-					StrandIterator begin(*jt, type);
-					std::string body(begin, AdvanceForward(begin, k));
-					dict[body] = it - bifurcationPos_[dir].begin();
-				}				
+				StrandIterator begin = *proxy[i];
+				std::string body(begin, AdvanceForward(begin, k));
+				dict[body] = bifId;
 			}
 		}		
 	}
 
-	BifurcationStorage::IteratorMap::const_iterator BifurcationStorage::LookUp(StrandIterator it) const
-	{
-		size_t strand = it.GetDirection() == DNASequence::positive ? 0 : 1;
-		if(it.GetInfoBit(strand))
-		{
-			IteratorList temp(1, it.Base());
-			BifurcationId bifId = NO_BIFURCATION;
-			IteratorPtr lookUp = temp.begin();
-			return posBifurcation_[strand].find(lookUp);		
-		}
-
-		return posBifurcation_[strand].end();
-	}
-
-	BifurcationStorage::IteratorMap::iterator BifurcationStorage::LookUp(StrandIterator it)
+	const Size * BifurcationStorage::LookUp(StrandIterator it) const
 	{
 		size_t strand = it.GetDirection() == DNASequence::positive ? 0 : 1;
 		if(it.GetInfoBit(strand))
 		{
-			IteratorList temp(1, it.Base());
-			BifurcationId bifId = NO_BIFURCATION;
-			IteratorPtr lookUp = temp.begin();
-			return posBifurcation_[strand].find(lookUp);		
+			return posSlot_[strand].Find(Address(it.Base()));
 		}
 
-		return posBifurcation_[strand].end();
+		return 0;
 	}
-}
\ No newline at end of file
+}
@@ -9,6 +9,8 @@
 #define _BIFURCATION_STORAGE_H_
 
 #include "dnasequence.h"
+#include "runstats.h"
+#include "addressmap.h"
 
 namespace SyntenyFinder
 {
@@ -20,10 +22,6 @@ namespace SyntenyFinder
 		typedef Size BifurcationId;
 		typedef DNASequence::SequencePosIterator PositiveIterator;
 		typedef DNASequence::SequencePosIterator BaseIterator;
-		typedef boost::container::slist<BaseIterator> IteratorList;
-		typedef IteratorList::iterator IteratorPtr;
-		typedef std::vector<IteratorList> ListVector;		
-		typedef std::vector<IteratorPtr> IteratorVector;
 		static const BifurcationId NO_BIFURCATION;
 
 		void Clear();
@@ -33,10 +31,27 @@ namespace SyntenyFinder
 		BifurcationStorage(size_t maxId);
 		void Cleanup();
 		void Dump(const DNASequence & sequence, size_t k, std::ostream & out) const;
+		//Bulk load of the points of one strand into an empty storage. The points are
+		//given in the order of their positions, the padding of each holds its bifurcation
+		void Load(DNASequence::Direction direction, const std::vector<BaseIterator> & point);
 		void ErasePoint(DNASequence::StrandIterator it);
 		void AddPoint(DNASequence::StrandIterator it, size_t bifId);
 		size_t CountBifurcations(size_t bifId) const;
 		size_t GetBifurcation(DNASequence::StrandIterator it) const;
+		template<DNASequence::Direction direction>
+			size_t GetBifurcation(DNASequence::FixedStrandIterator<direction> it) const
+			{
+				IncrementCounter(GET_BIFURCATION_COUNTER);
+				const size_t strand = direction == DNASequence::positive ? 0 : 1;
+				if(!it.GetInfoBit(strand))
+				{
+					return NO_BIFURCATION;
+				}
+
+				const Size * slot = posSlot_[strand].Find(&*it.Base());
+				return slot == 0 ? NO_BIFURCATION : slot_[strand][*slot].get_padding_int();
+			}
+
 		void NotifyBefore(StrandIterator begin, StrandIterator end);
 		void NotifyAfter(StrandIterator begin, StrandIterator end);
 		void FormDictionary(boost::unordered_map<std::string, size_t> & dict, size_t k) const;
@@ -45,26 +60,38 @@ namespace SyntenyFinder
 		{
 		public:
 			IteratorProxy() {}
-			IteratorProxy(IteratorPtr ptr, DNASequence::Direction direction): ptr_(ptr), direction_(direction)
+			IteratorProxy(const BifurcationStorage * storage, size_t strand, Size slot): storage_(storage), strand_(static_cast<Size>(strand)), slot_(slot)
 			{
 			}
 
 			bool Valid() const;
 			StrandIterator operator * () const;
 		private:
-			DNASequence::Direction direction_;
-			IteratorPtr ptr_;			
+			const BifurcationStorage * storage_;
+			Size strand_;
+			Size slot_;
 		};
 
+		//Points added later go first, like in a list with insertions at the front
 		template<class Iterator>
-			size_t ListPositions(size_t inBifId, Iterator out)
+			size_t ListPositions(size_t inBifId, Iterator out) const
 			{
-				size_t ret = 0;				
+				size_t ret = 0;
+				BifurcationId bifId = static_cast<BifurcationId>(inBifId);
 				for(size_t strand = 0; strand < 2; strand++)
 				{
-					for(IteratorList::iterator it = bifurcationPos_[strand][inBifId].begin(); it != bifurcationPos_[strand][inBifId].end(); ++it, ++ret)
+					for(Size slot = head_[strand][bifId]; slot != NO_SLOT; slot = next_[strand][slot - baseSize_[strand]], ++ret)
 					{
-						*out++ = IteratorProxy(it, static_cast<DNASequence::Direction>(strand));
+						*out++ = IteratorProxy(this, strand, slot);
+					}
+
+					for(Size slot = offset_[strand][bifId]; slot < offset_[strand][bifId + 1]; slot++)
+					{
+						if(slot_[strand][slot].get_padding_int() != REMOVED)
+						{
+							*out++ = IteratorProxy(this, strand, slot);
+							++ret;
+						}
 					}
 				}
 
@@ -74,49 +101,45 @@ namespace SyntenyFinder
 	private:					
 		static const size_t POSITIVE_BIT;
 		static const size_t NEGATIVE_BIT;
-
-		struct IteratorPtrHash
-		{
-		public:
-			size_t operator () (IteratorPtr it) const
-			{
-				return reinterpret_cast<size_t>(&(**it));
-			}
-		};
-
-		template<class T1, class T2>
-			struct IteratorPtrEqual
-			{
-			public:
-				bool operator () (const T1 & it1, const T2 & it2) const
-				{
-					return *it1 == *it2;
-				}
-			};
+		static const BifurcationId REMOVED;
+		static const Size NO_SLOT;
 
 		struct BifurcationRecord
 		{
 			size_t pos;
-			IteratorPtr ptrIt;
+			Size slot;
 			BifurcationId bifId;
 			BifurcationRecord() {}
-			BifurcationRecord(size_t pos, IteratorPtr ptrIt, BifurcationId bifId): pos(pos), ptrIt(ptrIt), bifId(bifId) {}
+			BifurcationRecord(size_t pos, Size slot, BifurcationId bifId): pos(pos), slot(slot), bifId(bifId) {}
 		};
 
-		BifurcationId ErasePointInternal(DNASequence::StrandIterator it, IteratorPtr & ret);
+		BifurcationId ErasePointInternal(DNASequence::StrandIterator it, Size & ret);
 		
-		typedef boost::unordered_set<IteratorPtr, IteratorPtrHash, IteratorPtrEqual<IteratorPtr, IteratorPtr> > IteratorMap;
-
+		//Slots of the points keyed by the address of the character
+		typedef AddressMap<Size> SlotMap;
+
+		//Points of each strand are stored in one array. Its beginning is split into
+		//segments of the bifurcations by the offsets, it is filled by the bulk load.
+		//Points added later go to the overflow area after it and are chained from the
+		//latest one. Erased points stay in place marked with NO_BIFURCATION until the
+		//cleanup, then the base slots are marked as removed and the overflow slots are reused
 		BifurcationId maxId_;
-		ListVector bifurcationPos_[2];
-		IteratorMap posBifurcation_[2];
-
-		size_t nowInvalid_;		
+		Size baseSize_[2];
+		std::vector<BaseIterator> slot_[2];
+		std::vector<Size> offset_[2];
+		std::vector<Size> head_[2];
+		std::vector<Size> next_[2];
+		std::vector<Size> count_[2];
+		std::vector<Size> free_[2];
+		SlotMap posSlot_[2];
+
+		//Records of the moved points, the buffers are kept between the notifications
+		size_t nowInvalid_;
+		size_t invalidSize_;
 		std::vector<std::vector<BifurcationRecord> > invalid_;
-		std::vector<std::pair<IteratorList*, IteratorPtr> > toClear_;
+		std::vector<std::pair<Size, BifurcationId> > toClear_[2];
 
-		IteratorMap::iterator LookUp(StrandIterator it);
-		IteratorMap::const_iterator LookUp(StrandIterator it) const;
+		const Size * LookUp(StrandIterator it) const;
 	};
 }
 
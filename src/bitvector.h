@@ -0,0 +1,117 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#ifndef _BIT_VECTOR_H_
+#define _BIT_VECTOR_H_
+
+#include "common.h"
+
+namespace SyntenyFinder
+{
+	class BitVector
+	{
+	public:
+		BitVector(): size_(0) {}
+
+		//Resizes the vector and clears all the bits, keeps the allocated memory
+		void Assign(size_t size)
+		{
+			size_ = size;
+			word_.assign((size + WORD_BITS - 1) / WORD_BITS, 0);
+		}
+
+		size_t Size() const
+		{
+			return size_;
+		}
+
+		void Set(size_t idx)
+		{
+			word_[idx / WORD_BITS] |= uint64_t(1) << (idx % WORD_BITS);
+		}
+
+		bool Get(size_t idx) const
+		{
+			return (word_[idx / WORD_BITS] & (uint64_t(1) << (idx % WORD_BITS))) != 0;
+		}
+
+		//Returns the position of the first clear bit at or after idx, Size() if there is none
+		size_t NextClear(size_t idx) const
+		{
+			if(idx >= size_)
+			{
+				return size_;
+			}
+
+			size_t nowWord = idx / WORD_BITS;
+			uint64_t bits = ~word_[nowWord] >> (idx % WORD_BITS);
+			if(bits != 0)
+			{
+				return std::min(size_, idx + TrailingZeros(bits));
+			}
+
+			for(++nowWord; nowWord < word_.size(); ++nowWord)
+			{
+				if(~word_[nowWord] != 0)
+				{
+					return std::min(size_, nowWord * WORD_BITS + TrailingZeros(~word_[nowWord]));
+				}
+			}
+
+			return size_;
+		}
+
+		//Returns the position of the last clear bit at or before idx, Size() if there is none
+		size_t PrevClear(size_t idx) const
+		{
+			size_t nowWord = idx / WORD_BITS;
+			uint64_t bits = ~word_[nowWord] << (WORD_BITS - 1 - idx % WORD_BITS);
+			if(bits != 0)
+			{
+				return idx - LeadingZeros(bits);
+			}
+
+			while(nowWord-- > 0)
+			{
+				if(~word_[nowWord] != 0)
+				{
+					return nowWord * WORD_BITS + WORD_BITS - 1 - LeadingZeros(~word_[nowWord]);
+				}
+			}
+
+			return size_;
+		}
+
+	private:
+		static const size_t WORD_BITS = 64;
+		size_t size_;
+		std::vector<uint64_t> word_;
+
+		static size_t TrailingZeros(uint64_t value)
+		{
+		#ifdef __GNUC__
+			return __builtin_ctzll(value);
+		#else
+			size_t ret = 0;
+			for(; (value & 1) == 0; value >>= 1, ++ret);
+			return ret;
+		#endif
+		}
+
+		static size_t LeadingZeros(uint64_t value)
+		{
+		#ifdef __GNUC__
+			return __builtin_clzll(value);
+		#else
+			size_t ret = 0;
+			for(; (value & (uint64_t(1) << (WORD_BITS - 1))) == 0; value <<= 1, ++ret);
+			return ret;
+		#endif
+		}
+	};
+}
+
+#endif
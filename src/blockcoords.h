@@ -0,0 +1,215 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#ifndef _BLOCK_COORDS_H_
+#define _BLOCK_COORDS_H_
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <stdint.h>
+
+//Binary file with coordinates of synteny blocks (blocks_coords.bin). The header
+//doesn't depend on the rest of Sibelia, so it can be used to read the file from
+//other programs. All integers are little-endian, the file consists of:
+//1. Header of BlockCoords::HEADER_SIZE bytes: magic string, version, number of
+//   chromosomes, number of instances, maximum block id and offsets of the sections below
+//2. Records of the instances sorted by (block id, chromosome, start), see BlockCoordsRecord
+//3. Block index: maxBlockId + 2 numbers, instances of the block "id" are records [index[id], index[id + 1])
+//4. Chromosome order: numbers of the records sorted by (chromosome, start)
+//5. Chromosome index: chrNumber + 1 numbers, instances located on the chromosome "chr" are
+//   listed in chromosome order at positions [index[chr], index[chr + 1])
+//6. Chromosome table: size, length of the description and the description of each chromosome
+namespace SyntenyFinder
+{
+	namespace BlockCoords
+	{
+		const char MAGIC[] = "SIBBLKS1";
+		const size_t MAGIC_SIZE = 8;
+		const uint32_t VERSION = 1;
+		const size_t HEADER_SIZE = 64;
+		const size_t RECORD_SIZE = 16;
+
+		inline void PutUInt32(std::string & out, uint32_t x)
+		{
+			for(size_t i = 0; i < 4; i++)
+			{
+				out.push_back(static_cast<char>((x >> (i * 8)) & 0xFF));
+			}
+		}
+
+		inline void PutUInt64(std::string & out, uint64_t x)
+		{
+			PutUInt32(out, static_cast<uint32_t>(x & 0xFFFFFFFF));
+			PutUInt32(out, static_cast<uint32_t>(x >> 32));
+		}
+
+		inline uint32_t GetUInt32(const char * data)
+		{
+			const unsigned char * byte = reinterpret_cast<const unsigned char*>(data);
+			return byte[0] | (byte[1] << 8) | (byte[2] << 16) | (static_cast<uint32_t>(byte[3]) << 24);
+		}
+
+		inline uint64_t GetUInt64(const char * data)
+		{
+			return GetUInt32(data) | (static_cast<uint64_t>(GetUInt32(data + 4)) << 32);
+		}
+	}
+
+	//An instance of a synteny block. The chromosome is zero-based, start and end are
+	//one-based as in blocks_coords.txt, so start > end for the negative strand
+	struct BlockCoordsRecord
+	{
+		int32_t signedId;
+		uint32_t chr;
+		uint32_t start;
+		uint32_t end;
+	};
+
+	//Reader of the binary file. It doesn't own the data, so the file can be mmapped
+	//or loaded with ReadBlockCoordsFile. All lookups take O(1) time.
+	class BlockCoordsReader
+	{
+	public:
+		BlockCoordsReader(const char * data, size_t size): data_(data), size_(size)
+		{
+			using namespace BlockCoords;
+			if(size < HEADER_SIZE || memcmp(data, MAGIC, MAGIC_SIZE) != 0 || GetUInt32(data + 8) != VERSION)
+			{
+				throw std::runtime_error("Not a blocks coordinates file or unsupported version");
+			}
+
+			chrNumber_ = GetUInt32(data + 12);
+			instanceNumber_ = GetUInt32(data + 16);
+			maxBlockId_ = GetUInt32(data + 20);
+			record_ = data + CheckedOffset(24, static_cast<uint64_t>(instanceNumber_) * RECORD_SIZE);
+			blockIndex_ = data + CheckedOffset(32, (static_cast<uint64_t>(maxBlockId_) + 2) * 4);
+			chrOrder_ = data + CheckedOffset(40, static_cast<uint64_t>(instanceNumber_) * 4);
+			chrIndex_ = data + CheckedOffset(48, (static_cast<uint64_t>(chrNumber_) + 1) * 4);
+			const char * table = data + CheckedOffset(56, 0);
+			for(uint32_t chr = 0; chr < chrNumber_; chr++)
+			{
+				if(table + 12 > data + size)
+				{
+					throw std::runtime_error("Truncated blocks coordinates file");
+				}
+
+				uint64_t chrSize = GetUInt64(table);
+				uint32_t length = GetUInt32(table + 8);
+				table += 12;
+				if(table + length > data + size)
+				{
+					throw std::runtime_error("Truncated blocks coordinates file");
+				}
+
+				chrSize_.push_back(chrSize);
+				chrDescription_.push_back(std::string(table, table + length));
+				table += length;
+			}
+		}
+
+		size_t ChrNumber() const
+		{
+			return chrNumber_;
+		}
+
+		uint64_t ChrSize(size_t chr) const
+		{
+			return chrSize_[chr];
+		}
+
+		const std::string& ChrDescription(size_t chr) const
+		{
+			return chrDescription_[chr];
+		}
+
+		size_t InstanceNumber() const
+		{
+			return instanceNumber_;
+		}
+
+		size_t MaxBlockId() const
+		{
+			return maxBlockId_;
+		}
+
+		BlockCoordsRecord Record(size_t index) const
+		{
+			using BlockCoords::GetUInt32;
+			const char * data = record_ + index * BlockCoords::RECORD_SIZE;
+			BlockCoordsRecord ret;
+			ret.signedId = static_cast<int32_t>(GetUInt32(data));
+			ret.chr = GetUInt32(data + 4);
+			ret.start = GetUInt32(data + 8);
+			ret.end = GetUInt32(data + 12);
+			return ret;
+		}
+
+		//Range of the records of the block, it's empty if there is no such block
+		std::pair<size_t, size_t> Block(size_t id) const
+		{
+			if(id > maxBlockId_)
+			{
+				return std::make_pair(size_t(0), size_t(0));
+			}
+
+			return std::make_pair(BlockCoords::GetUInt32(blockIndex_ + id * 4), BlockCoords::GetUInt32(blockIndex_ + id * 4 + 4));
+		}
+
+		size_t ChrInstanceNumber(size_t chr) const
+		{
+			return BlockCoords::GetUInt32(chrIndex_ + chr * 4 + 4) - BlockCoords::GetUInt32(chrIndex_ + chr * 4);
+		}
+
+		//Instances located on the chromosome, in order of their positions
+		BlockCoordsRecord ChrInstance(size_t chr, size_t index) const
+		{
+			size_t pos = BlockCoords::GetUInt32(chrIndex_ + chr * 4) + index;
+			return Record(BlockCoords::GetUInt32(chrOrder_ + pos * 4));
+		}
+
+	private:
+		const char * data_;
+		size_t size_;
+		uint32_t chrNumber_;
+		uint32_t instanceNumber_;
+		uint32_t maxBlockId_;
+		const char * record_;
+		const char * blockIndex_;
+		const char * chrOrder_;
+		const char * chrIndex_;
+		std::vector<uint64_t> chrSize_;
+		std::vector<std::string> chrDescription_;
+
+		uint64_t CheckedOffset(size_t headerPos, uint64_t length) const
+		{
+			uint64_t offset = BlockCoords::GetUInt64(data_ + headerPos);
+			if(offset > size_ || length > size_ - offset)
+			{
+				throw std::runtime_error("Truncated blocks coordinates file");
+			}
+
+			return offset;
+		}
+	};
+
+	inline void ReadBlockCoordsFile(const std::string & fileName, std::vector<char> & buffer)
+	{
+		std::ifstream in(fileName.c_str(), std::ios::in | std::ios::binary);
+		if(!in)
+		{
+			throw std::runtime_error(("Cannot open file " + fileName).c_str());
+		}
+
+		buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+}
+
+#endif
@@ -5,6 +5,7 @@
 //****************************************************************************
 
 #include "blockfinder.h"
+#include "runstats.h"
 
 namespace SyntenyFinder
 {
@@ -15,6 +16,7 @@ namespace SyntenyFinder
 
 	size_t BlockFinder::SimplifyGraph(DNASequence & sequence, BifurcationStorage & bifStorage, size_t k, size_t minBranchSize, size_t maxIterations, ProgressCallBack callBack)
 	{
+		PhaseTimer timer("bulge_removal");
 		size_t count = 0;
 		size_t totalBulges = 0;
 		size_t iterations = 0;
@@ -25,13 +27,33 @@ namespace SyntenyFinder
 			callBack(totalProgress, start);
 		}
 
+		//Only the bifurcations marked as dirty are processed. All of them are dirty at
+		//the start, a collapse marks the ones that can see the changed branch. A mark
+		//set to an id after the current one is processed in the same iteration
+		std::vector<Bool> dirty(bifStorage.GetMaxId() + 1, true);
 		size_t threshold = (bifStorage.GetMaxId() * maxIterations) / PROGRESS_STRIDE;
 		do
 		{
 			iterations++;
+			size_t iterationBulges = 0;
+			size_t worklist = 0;
+			size_t skipped = 0;
 			for(size_t id = 0; id <= bifStorage.GetMaxId(); id++)
 			{			
-				totalBulges += RemoveBulges(sequence, bifStorage, k, minBranchSize, id);
+				if(dirty[id])
+				{
+					dirty[id] = false;
+					if(maxMultiplicity_ > 0 && bifStorage.CountBifurcations(id) > maxMultiplicity_)
+					{
+						skipped++;
+					}
+					else
+					{
+						worklist++;
+						iterationBulges += RemoveBulges(sequence, bifStorage, k, minBranchSize, id, dirty);
+					}
+				}
+
 				if(++count >= threshold && !callBack.empty())
 				{
 					count = 0;
@@ -39,8 +61,14 @@ namespace SyntenyFinder
 					callBack(totalProgress, run);
 				}
 			}
+
+			totalBulges += iterationBulges;
+			RecordPhaseValue("worklist", worklist);
+			RecordPhaseValue("skipped_bifurcations", skipped);
+			RecordPhaseValue("bulges", iterationBulges);
+			anyChanges = std::find(dirty.begin(), dirty.end(), true) != dirty.end();
 		}
-		while((totalBulges > 0) && iterations < maxIterations);
+		while(anyChanges && iterations < maxIterations);
 
 		if(!callBack.empty())
 		{
@@ -51,17 +79,48 @@ namespace SyntenyFinder
 	}
 	
 	BlockFinder::BlockFinder(const std::vector<FASTARecord> & chrList):
-		originalChrList_(&chrList)
+		workspace_(0), bloomK_(0), fmIndex_(false), maxMultiplicity_(0), scratch_(&ownScratch_), originalChrList_(&chrList)
 	{
 		Init(chrList);
 	}
 
 	BlockFinder::BlockFinder(const std::vector<FASTARecord> & chrList, const std::string & tempDir):
-		originalChrList_(&chrList), tempDir_(tempDir)
+		tempDir_(tempDir), workspace_(0), bloomK_(0), fmIndex_(false), maxMultiplicity_(0), scratch_(&ownScratch_), originalChrList_(&chrList)
 	{
 		Init(chrList);
 	}
 
+	void BlockFinder::SetWorkspace(Workspace * workspace)
+	{
+		workspace_ = workspace;
+		scratch_ = workspace != 0 ? &workspace->scratch : &ownScratch_;
+	}
+
+	void BlockFinder::SetBloomK(size_t bloomK)
+	{
+		bloomK_ = bloomK;
+	}
+
+	void BlockFinder::SetFMIndex(bool fmIndex)
+	{
+		fmIndex_ = fmIndex;
+	}
+
+	void BlockFinder::SetMaxMultiplicity(size_t maxMultiplicity)
+	{
+		maxMultiplicity_ = maxMultiplicity;
+	}
+
+	IndexedSequence::Enumeration BlockFinder::GetEnumeration(size_t k) const
+	{
+		if(bloomK_ > 0 && k >= bloomK_)
+		{
+			return IndexedSequence::bloomFilter;
+		}
+
+		return fmIndex_ ? IndexedSequence::fmIndex : IndexedSequence::suffixArray;
+	}
+
 	void BlockFinder::Init(const std::vector<FASTARecord> & chrList)
 	{
 		rawSeq_.resize(chrList.size());
@@ -77,7 +136,7 @@ namespace SyntenyFinder
 
 	size_t BlockFinder::PerformGraphSimplifications(size_t k, size_t minBranchSize, size_t maxIterations, ProgressCallBack f)
 	{
-		IndexedSequence iseq(rawSeq_, originalPos_, k, tempDir_, true);
+		IndexedSequence iseq(rawSeq_, originalPos_, k, tempDir_, true, workspace_, GetEnumeration(k));
 		iseq_ = &iseq;
 		DNASequence & sequence = iseq.Sequence();
 		BifurcationStorage & bifStorage = iseq.BifStorage();		
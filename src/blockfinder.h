@@ -9,6 +9,7 @@
 
 #include "blockinstance.h"
 #include "indexedsequence.h"
+#include "scratch.h"
 
 namespace SyntenyFinder
 {
@@ -24,6 +25,8 @@ namespace SyntenyFinder
 
 	typedef char Bool;	
 	typedef std::vector<BifurcationStorage::IteratorProxy> IteratorProxyVector;
+	typedef ScratchVector<BifurcationStorage::IteratorProxy>::Type ScratchProxyVector;
+	typedef ScratchVector<std::pair<size_t, size_t> >::Type ScratchPairVector;
 	
 	class BlockFinder
 	{
@@ -43,11 +46,28 @@ namespace SyntenyFinder
 		void SerializeCondensedGraph(size_t k, std::ostream & out, ProgressCallBack f = ProgressCallBack());
 		void GenerateSyntenyBlocks(size_t k, size_t trimK, size_t minSize, std::vector<BlockInstance> & block, bool sharedOnly = false, ProgressCallBack f = ProgressCallBack());
 		size_t PerformGraphSimplifications(size_t k, size_t minBranchSize, size_t maxIterations, ProgressCallBack f = ProgressCallBack());
+		//Buffers to reuse, the workspace must outlive the finder
+		void SetWorkspace(Workspace * workspace);
+		//Graphs with k >= bloomK are built with the Bloom filter enumeration, 0 means never
+		void SetBloomK(size_t bloomK);
+		//Other graphs are built with the FM-index of the positive strand instead of the suffix array
+		void SetFMIndex(bool fmIndex);
+		//Bifurcations with more occurrences are skipped by the simplification, 0 means no limit
+		void SetMaxMultiplicity(size_t maxMultiplicity);
 	private:
 		DISALLOW_COPY_AND_ASSIGN(BlockFinder);
+		IndexedSequence::Enumeration GetEnumeration(size_t k) const;
 		typedef std::vector<Pos> PosVector;
 		typedef std::pair<size_t, size_t> ChrPos;
 		std::string tempDir_;
+		Workspace * workspace_;
+		size_t bloomK_;
+		bool fmIndex_;
+		size_t maxMultiplicity_;
+		//Temporaries of RemoveBulges, reset for each bifurcation. The arena of the
+		//workspace is used if there is one, so the blocks are kept between the jobs
+		ScratchArena ownScratch_;
+		ScratchArena * scratch_;
 		IndexedSequence * iseq_;		
 		std::vector<std::string> rawSeq_;	
 		std::vector<size_t> originalSize_;
@@ -70,7 +90,6 @@ namespace SyntenyFinder
 			size_t GetOriginalPosition() const;
 			size_t GetOriginalLength() const;
 			char GetFirstChar() const;
-			static bool PositiveEdge(const Edge & e);
 			bool operator < (const Edge & e);
 		private:
 			size_t chr;
@@ -84,6 +103,81 @@ namespace SyntenyFinder
 			char firstChar;
 		};		
 
+		//Edges of the condensed graph kept by columns of 32-bit fields
+		class EdgeTable
+		{
+		public:
+			void Clear();
+			size_t Size() const;
+			void PushBack(size_t chr, DNASequence::Direction direction, size_t startVertex, size_t endVertex, size_t actualPosition, size_t actualLength, size_t originalPosition, size_t originalLength, char firstChar);
+			void Append(const EdgeTable & table);
+			void Swap(EdgeTable & table);
+			Edge operator [] (size_t idx) const;
+			DNASequence::Direction GetDirection(size_t idx) const
+			{
+				return static_cast<DNASequence::Direction>(direction_[idx]);
+			}
+
+			//Compares the edges by the start vertex, the end vertex and the first char
+			bool NaturalLess(size_t a, size_t b) const
+			{
+				if(startVertex_[a] != startVertex_[b])
+				{
+					return startVertex_[a] < startVertex_[b];
+				}
+
+				if(endVertex_[a] != endVertex_[b])
+				{
+					return endVertex_[a] < endVertex_[b];
+				}
+
+				return static_cast<size_t>(firstChar_[a]) < static_cast<size_t>(firstChar_[b]);
+			}
+
+			bool DirectionLess(size_t a, size_t b) const
+			{
+				return direction_[a] < direction_[b];
+			}
+
+			//Comparators of the indices of the edges
+			struct NaturalOrder
+			{
+			public:
+				NaturalOrder(const EdgeTable * table): table_(table) {}
+				bool operator () (SyntenyFinder::Size a, SyntenyFinder::Size b) const
+				{
+					return table_->NaturalLess(a, b);
+				}
+
+			private:
+				const EdgeTable * table_;
+			};
+
+			struct DirectionOrder
+			{
+			public:
+				DirectionOrder(const EdgeTable * table): table_(table) {}
+				bool operator () (SyntenyFinder::Size a, SyntenyFinder::Size b) const
+				{
+					return table_->DirectionLess(a, b);
+				}
+
+			private:
+				const EdgeTable * table_;
+			};
+
+		private:
+			std::vector<SyntenyFinder::Size> chr_;
+			std::vector<SyntenyFinder::Size> startVertex_;
+			std::vector<SyntenyFinder::Size> endVertex_;
+			std::vector<Pos> actualPosition_;
+			std::vector<Pos> actualLength_;
+			std::vector<Pos> originalPosition_;
+			std::vector<Pos> originalLength_;
+			std::vector<char> direction_;
+			std::vector<char> firstChar_;
+		};
+
 		struct EdgeGroupComparer
 		{
 		public:
@@ -94,31 +188,28 @@ namespace SyntenyFinder
 				return size1 > size2;
 			}
 
-			EdgeGroupComparer(const std::vector<Edge> * edge): edge_(edge) {}
+			EdgeGroupComparer(const EdgeTable * edge): edge_(edge) {}
 		private:
-			const std::vector<Edge> * edge_;			
+			const EdgeTable * edge_;			
 		};		
 
-		static bool EdgeEmpty(const Edge & a, size_t k);				
-		static std::vector<size_t> EdgeToVector(const Edge & a);
-		static bool CompareEdgesNaturally(const Edge & a, const Edge & b);
-		static bool CompareEdgesByDirection(const Edge & a, const Edge & b);
 		void PrintRaw(const DNASequence & s, std::ostream & out);
 		void PrintPath(const DNASequence & s, StrandIterator e, size_t k, size_t distance, std::ostream & out);
 		void SpellBulges(const DNASequence & sequence, size_t k, size_t bifStart, size_t bifEnd, const std::vector<StrandIterator> & startKMer, const std::vector<VisitData> & visitData);
 		
 		void Init(const std::vector<FASTARecord> & chrList);		
-		size_t RemoveBulges(DNASequence & sequence, BifurcationStorage & bifStorage, size_t k, size_t minBranchSize, size_t bifId);		
-		void ListEdges(const DNASequence & sequence, const BifurcationStorage & bifStorage, size_t k, std::vector<Edge> & edge) const;
+		size_t RemoveBulges(DNASequence & sequence, BifurcationStorage & bifStorage, size_t k, size_t minBranchSize, size_t bifId, std::vector<Bool> & dirty);		
+		//Lists the edges having at least minSize bases of the original sequence
+		void ListEdges(const DNASequence & sequence, const BifurcationStorage & bifStorage, size_t k, size_t minSize, EdgeTable & edge) const;
 		bool TrimBlocks(std::vector<Edge> & block, size_t trimK, size_t minSize);
 		size_t SimplifyGraph(DNASequence & sequence, BifurcationStorage & bifStorage, size_t k, size_t minBranchSize, size_t maxIterations, ProgressCallBack f = ProgressCallBack());
-		void CollapseBulgeGreedily(DNASequence & sequence, BifurcationStorage & bifStorage, size_t k, IteratorProxyVector & startKMer, VisitData sourceData, VisitData targetData);
-		void UpdateBifurcations(DNASequence & sequence, BifurcationStorage & bifStorage, size_t k, const IteratorProxyVector & startKMer, VisitData sourceData, VisitData targetData,
-			const std::vector<std::pair<size_t, size_t> > & lookForward, const std::vector<std::pair<size_t, size_t> > & lookBack);
+		void CollapseBulgeGreedily(DNASequence & sequence, BifurcationStorage & bifStorage, size_t k, ScratchProxyVector & startKMer, VisitData sourceData, VisitData targetData);
+		void UpdateBifurcations(DNASequence & sequence, BifurcationStorage & bifStorage, size_t k, const ScratchProxyVector & startKMer, VisitData sourceData, VisitData targetData,
+			const ScratchPairVector & lookForward, const ScratchPairVector & lookBack);
 		typedef std::vector<Bool> Indicator;
-		typedef std::vector<Edge>::iterator EdgeIterator;
+		typedef std::vector<Size>::const_iterator EdgeIterator;
 		
-		void ResolveOverlap(EdgeIterator start, EdgeIterator end, size_t minSize, std::vector<Indicator> & overlap, std::vector<Edge> & nowBlock) const;
+		void ResolveOverlap(const EdgeTable & edge, EdgeIterator start, EdgeIterator end, size_t minSize, std::vector<Indicator> & overlap, std::vector<Edge> & nowBlock) const;
 		void Extend(std::vector<StrandIterator> current, std::vector<size_t> & start, std::vector<size_t> & end, std::vector<Indicator> & overlap, std::set<ChrPos> & localOverlap, IndexedSequence & iseq, bool forward);
 	};
 }
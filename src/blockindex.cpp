@@ -0,0 +1,90 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#include "blockindex.h"
+
+namespace SyntenyFinder
+{
+	namespace
+	{
+		bool LessById(const BlockInstance & a, const BlockInstance & b)
+		{
+			if(a.GetBlockId() != b.GetBlockId())
+			{
+				return a.GetBlockId() < b.GetBlockId();
+			}
+
+			return a < b;
+		}
+
+		bool LessByStart(const BlockInstance & a, const BlockInstance & b)
+		{
+			return a.GetStart() < b.GetStart();
+		}
+
+		bool SameId(const BlockInstance & a, const BlockInstance & b)
+		{
+			return a.GetBlockId() == b.GetBlockId();
+		}
+
+		bool SameChr(const BlockInstance & a, const BlockInstance & b)
+		{
+			return a.GetChrId() == b.GetChrId();
+		}
+
+		template<class F>
+			void FindRanges(const std::vector<BlockInstance> & block, F same, std::vector<IndexPair> & range)
+			{
+				range.clear();
+				for(size_t now = 0; now < block.size(); )
+				{
+					size_t prev = now;
+					for(; now < block.size() && same(block[prev], block[now]); now++);
+					range.push_back(IndexPair(prev, now));
+				}
+			}
+	}
+
+	BlockIndex::BlockIndex(const BlockList & blockList, size_t chrNumber): chrNumber_(chrNumber), byId_(blockList), byChr_(blockList)
+	{
+		std::sort(byChr_.begin(), byChr_.end(), CompareBlocksNaturally);
+		std::sort(byId_.begin(), byId_.end(), LessById);
+		byStart_ = byChr_;
+		std::stable_sort(byStart_.begin(), byStart_.end(), LessByStart);
+		FindRanges(byId_, SameId, idGroup_);
+		FindRanges(byChr_, SameChr, chrGroup_);
+	}
+
+	size_t BlockIndex::ChrNumber() const
+	{
+		return chrNumber_;
+	}
+
+	const BlockIndex::BlockList& BlockIndex::ById() const
+	{
+		return byId_;
+	}
+
+	const BlockIndex::BlockList& BlockIndex::ByChr() const
+	{
+		return byChr_;
+	}
+
+	const BlockIndex::BlockList& BlockIndex::ByStart() const
+	{
+		return byStart_;
+	}
+
+	const std::vector<IndexPair>& BlockIndex::IdGroup() const
+	{
+		return idGroup_;
+	}
+
+	const std::vector<IndexPair>& BlockIndex::ChrGroup() const
+	{
+		return chrGroup_;
+	}
+}
@@ -0,0 +1,43 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#ifndef _BLOCK_INDEX_H_
+#define _BLOCK_INDEX_H_
+
+#include "blockinstance.h"
+
+namespace SyntenyFinder
+{
+	//Immutable index over a list of synteny blocks instances. All the output writers 
+	//share it instead of sorting and grouping their own copies of the list.
+	class BlockIndex
+	{
+	public:
+		typedef std::vector<BlockInstance> BlockList;
+		BlockIndex(const BlockList & blockList, size_t chrNumber);
+		size_t ChrNumber() const;
+		//Instances sorted by (block id, chromosome, start)
+		const BlockList& ById() const;
+		//Instances sorted by (chromosome, start)
+		const BlockList& ByChr() const;
+		//Instances sorted by start, ties are ordered by chromosome
+		const BlockList& ByStart() const;
+		//Ranges of instances of the same block in ById()
+		const std::vector<IndexPair>& IdGroup() const;
+		//Ranges of instances located on the same chromosome in ByChr()
+		const std::vector<IndexPair>& ChrGroup() const;
+	private:
+		DISALLOW_COPY_AND_ASSIGN(BlockIndex);
+		size_t chrNumber_;
+		BlockList byId_;
+		BlockList byChr_;
+		BlockList byStart_;
+		std::vector<IndexPair> idGroup_;
+		std::vector<IndexPair> chrGroup_;
+	};
+}
+
+#endif
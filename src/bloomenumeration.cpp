@@ -0,0 +1,425 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#include "indexedsequence.h"
+#include "runstats.h"
+
+namespace SyntenyFinder
+{
+	namespace
+	{
+		//The k-mers are split into rounds by hash, each round needs a filter only
+		//for the edges adjacent to its own k-mers. Large inputs get more rounds, so
+		//the filter of a round never takes more than BLOOM_MAX_BITS
+		const size_t BLOOM_ROUNDS = 8;
+		const size_t BLOOM_BITS_PER_EDGE = 16;
+		const size_t BLOOM_MAX_BITS = size_t(1) << 28;
+		const size_t BLOOM_HASH_FUNCTIONS = 6;
+		const size_t NO_RECORD = static_cast<size_t>(-1);
+
+		//Characters of a chromosome read along one of the strands, the negative
+		//strand is complemented on the fly instead of being copied
+		char CharAt(const std::string & str, size_t strand, size_t pos)
+		{
+			return strand == 0 ? str[pos] : DNASequence::Translate(str[str.size() - 1 - pos]);
+		}
+
+		class StrandChar: public std::iterator<std::bidirectional_iterator_tag, char>
+		{
+		public:
+			StrandChar() {}
+			StrandChar(const std::string & str, size_t strand, size_t pos): str_(&str), strand_(strand), pos_(pos) {}
+
+			char operator * () const
+			{
+				return CharAt(*str_, strand_, pos_);
+			}
+
+			StrandChar & operator ++ ()
+			{
+				++pos_;
+				return *this;
+			}
+
+			StrandChar operator ++ (int)
+			{
+				StrandChar ret = *this;
+				++pos_;
+				return ret;
+			}
+
+			StrandChar & operator -- ()
+			{
+				--pos_;
+				return *this;
+			}
+
+			StrandChar operator -- (int)
+			{
+				StrandChar ret = *this;
+				--pos_;
+				return ret;
+			}
+
+			bool operator == (const StrandChar & other) const
+			{
+				return pos_ == other.pos_ && str_ == other.str_ && strand_ == other.strand_;
+			}
+
+			bool operator != (const StrandChar & other) const
+			{
+				return !(*this == other);
+			}
+
+		private:
+			const std::string * str_;
+			size_t strand_;
+			size_t pos_;
+		};
+
+		typedef SlidingWindow<StrandChar> Window;
+
+		uint64_t Mix(uint64_t x)
+		{
+			x ^= x >> 33;
+			x *= 0xff51afd7ed558ccdULL;
+			x ^= x >> 33;
+			x *= 0xc4ceb9fe1a85ec53ULL;
+			x ^= x >> 33;
+			return x;
+		}
+
+		class BloomFilter
+		{
+		public:
+			BloomFilter(size_t bits): bits_(bits), word_((bits + 63) / 64, 0) {}
+			void Add(uint64_t value)
+			{
+				uint64_t h1 = Mix(value);
+				uint64_t h2 = Mix(h1) | 1;
+				for(size_t i = 0; i < BLOOM_HASH_FUNCTIONS; i++, h1 += h2)
+				{
+					size_t bit = static_cast<size_t>(h1 % bits_);
+					word_[bit >> 6] |= uint64_t(1) << (bit & 63);
+				}
+			}
+
+			bool In(uint64_t value) const
+			{
+				uint64_t h1 = Mix(value);
+				uint64_t h2 = Mix(h1) | 1;
+				for(size_t i = 0; i < BLOOM_HASH_FUNCTIONS; i++, h1 += h2)
+				{
+					size_t bit = static_cast<size_t>(h1 % bits_);
+					if((word_[bit >> 6] & (uint64_t(1) << (bit & 63))) == 0)
+					{
+						return false;
+					}
+				}
+
+				return true;
+			}
+
+		private:
+			size_t bits_;
+			std::vector<uint64_t> word_;
+		};
+
+		//Bit of a character that precedes or follows a k-mer, SEPARATION_CHAR marks
+		//the end of a sequence
+		char CharBit(char ch)
+		{
+			size_t idx = DEFINITE_BASE.find(ch);
+			return static_cast<char>(1 << (idx == std::string::npos ? DEFINITE_BASE.size() : idx));
+		}
+
+		bool Branching(char mask)
+		{
+			return (mask & CharBit(IndexedSequence::SEPARATION_CHAR)) != 0 || (mask & (mask - 1)) != 0;
+		}
+
+		//Distinct k-mers that may be bifurcations. A k-mer is stored as a reference to
+		//one of its occurrences, records with the same hash are chained
+		class JunctionSet
+		{
+		public:
+			struct Record
+			{
+				Size strand;
+				Size chr;
+				Size pos;
+				char prev;
+				char next;
+				size_t id;
+				size_t chain;
+			};
+
+			JunctionSet(const std::vector<std::string> & data, size_t k): data_(data), k_(k) {}
+
+			//Makes room for the given number of records in total
+			void Reserve(size_t count)
+			{
+				record_.reserve(count);
+				head_.reserve(count);
+			}
+
+			size_t Find(uint64_t hash, size_t strand, size_t chr, size_t pos) const
+			{
+				boost::unordered_map<uint64_t, size_t>::const_iterator it = head_.find(hash);
+				for(size_t now = it == head_.end() ? NO_RECORD : it->second; now != NO_RECORD; now = record_[now].chain)
+				{
+					if(Equal(record_[now], strand, chr, pos))
+					{
+						return now;
+					}
+				}
+
+				return NO_RECORD;
+			}
+
+			void Add(uint64_t hash, size_t strand, size_t chr, size_t pos)
+			{
+				if(Find(hash, strand, chr, pos) == NO_RECORD)
+				{
+					Record record;
+					record.strand = static_cast<Size>(strand);
+					record.chr = static_cast<Size>(chr);
+					record.pos = static_cast<Size>(pos);
+					record.prev = record.next = 0;
+					record.id = NO_RECORD;
+					std::pair<boost::unordered_map<uint64_t, size_t>::iterator, bool> ret = head_.insert(std::make_pair(hash, record_.size()));
+					record.chain = ret.second ? NO_RECORD : ret.first->second;
+					ret.first->second = record_.size();
+					record_.push_back(record);
+				}
+			}
+
+			Record & Get(size_t idx)
+			{
+				return record_[idx];
+			}
+
+			size_t Count() const
+			{
+				return record_.size();
+			}
+
+			bool Less(size_t a, size_t b) const
+			{
+				const Record & ra = record_[a];
+				const Record & rb = record_[b];
+				return std::lexicographical_compare(Begin(ra.strand, ra.chr, ra.pos), Begin(ra.strand, ra.chr, ra.pos + k_),
+					Begin(rb.strand, rb.chr, rb.pos), Begin(rb.strand, rb.chr, rb.pos + k_));
+			}
+
+		private:
+			const std::vector<std::string> & data_;
+			size_t k_;
+			std::vector<Record> record_;
+			boost::unordered_map<uint64_t, size_t> head_;
+
+			StrandChar Begin(size_t strand, size_t chr, size_t pos) const
+			{
+				return StrandChar(data_[chr], strand, pos);
+			}
+
+			bool Equal(const Record & record, size_t strand, size_t chr, size_t pos) const
+			{
+				return std::equal(Begin(strand, chr, pos), Begin(strand, chr, pos + k_), Begin(record.strand, record.chr, record.pos));
+			}
+		};
+
+		struct Candidate
+		{
+			uint64_t hash;
+			Size strand;
+			Size chr;
+			Size pos;
+			Candidate() {}
+			Candidate(uint64_t hash, size_t strand, size_t chr, size_t pos): hash(hash),
+				strand(static_cast<Size>(strand)), chr(static_cast<Size>(chr)), pos(static_cast<Size>(pos)) {}
+		};
+
+		class JunctionLess
+		{
+		public:
+			JunctionLess(const JunctionSet & junction): junction_(junction) {}
+			bool operator()(size_t a, size_t b) const
+			{
+				return junction_.Less(a, b);
+			}
+
+		private:
+			const JunctionSet & junction_;
+		};
+
+		bool InRound(uint64_t hash, size_t round, size_t rounds)
+		{
+			return Mix(hash) % rounds == round;
+		}
+	}
+
+	//The same bifurcations as the suffix array enumeration gives, without the suffix
+	//array. For each round the (k + 1)-mers adjacent to the k-mers of the round are
+	//put to a Bloom filter, then the k-mers with more than one extension in the
+	//filter become candidates. The exact pass over the sequences keeps only true
+	//bifurcations, they are numbered in lexicographic order like in the suffix array.
+	//Both strands are read from the input, the candidate table is sized from the
+	//candidates found in each round. The filter has to hold every edge, so it can't
+	//be sized from the candidates. Instead it is capped by BLOOM_MAX_BITS, a larger
+	//input is processed in more rounds.
+	size_t IndexedSequence::EnumerateBifurcationsBloom(const std::vector<std::string> & data, std::vector<BifurcationInstance> & positiveBif, std::vector<BifurcationInstance> & negativeBif)
+	{
+		positiveBif.clear();
+		negativeBif.clear();
+		size_t kmers = 0;
+		for(size_t chr = 0; chr < data.size(); chr++)
+		{
+			kmers += data[chr].size() >= k_ ? 2 * (data[chr].size() - k_ + 1) : 0;
+		}
+
+		uint64_t highPow = 1;
+		for(size_t i = 0; i < k_; i++)
+		{
+			highPow *= Window::HASH_BASE;
+		}
+
+		size_t rounds = std::max(BLOOM_ROUNDS, (BLOOM_BITS_PER_EDGE * 2 * kmers + BLOOM_MAX_BITS - 1) / BLOOM_MAX_BITS);
+		JunctionSet junction(data, k_);
+		{
+			PhaseTimer timer("bloom_filter");
+			std::vector<Candidate> found;
+			for(size_t round = 0; round < rounds; round++)
+			{
+				BloomFilter filter(std::max<size_t>(BLOOM_BITS_PER_EDGE * 2 * kmers / rounds, 64));
+				for(size_t strand = 0; strand < 2; strand++)
+				{
+					for(size_t chr = 0; chr < data.size(); chr++)
+					{
+						const std::string & str = data[chr];
+						if(str.size() >= k_)
+						{
+							Window window(StrandChar(str, strand, 0), StrandChar(str, strand, str.size()), k_);
+							for(size_t pos = 0; pos + k_ < str.size(); pos++)
+							{
+								uint64_t prefix = window.GetValue();
+								window.Move();
+								if(InRound(prefix, round, rounds) || InRound(window.GetValue(), round, rounds))
+								{
+									filter.Add(prefix * Window::HASH_BASE + CharAt(str, strand, pos + k_));
+								}
+							}
+						}
+					}
+				}
+
+				found.clear();
+				for(size_t strand = 0; strand < 2; strand++)
+				{
+					for(size_t chr = 0; chr < data.size(); chr++)
+					{
+						const std::string & str = data[chr];
+						if(str.size() >= k_)
+						{
+							Window window(StrandChar(str, strand, 0), StrandChar(str, strand, str.size()), k_);
+							for(size_t pos = 0; pos + k_ <= str.size(); pos++)
+							{
+								uint64_t value = window.GetValue();
+								if(InRound(value, round, rounds))
+								{
+									size_t in = 0;
+									size_t out = 0;
+									for(size_t i = 0; i < DEFINITE_BASE.size(); i++)
+									{
+										in += filter.In(DEFINITE_BASE[i] * highPow + value) ? 1 : 0;
+										out += filter.In(value * Window::HASH_BASE + DEFINITE_BASE[i]) ? 1 : 0;
+									}
+
+									if(in > 1 || out > 1 || pos == 0 || pos + k_ == str.size())
+									{
+										found.push_back(Candidate(value, strand, chr, pos));
+									}
+								}
+
+								if(pos + k_ < str.size())
+								{
+									window.Move();
+								}
+							}
+						}
+					}
+				}
+
+				junction.Reserve(junction.Count() + found.size());
+				for(size_t i = 0; i < found.size(); i++)
+				{
+					junction.Add(found[i].hash, found[i].strand, found[i].chr, found[i].pos);
+				}
+			}
+		}
+
+		size_t bifurcationCount = 0;
+		PhaseTimer timer("bifurcation_enumeration");
+		for(size_t pass = 0; pass < 2; pass++)
+		{
+			for(size_t strand = 0; strand < 2; strand++)
+			{
+				for(size_t chr = 0; chr < data.size(); chr++)
+				{
+					const std::string & str = data[chr];
+					if(str.size() >= k_)
+					{
+						Window window(StrandChar(str, strand, 0), StrandChar(str, strand, str.size()), k_);
+						for(size_t pos = 0; pos + k_ <= str.size(); pos++)
+						{
+							size_t idx = junction.Find(window.GetValue(), strand, chr, pos);
+							if(idx != NO_RECORD && pass == 0)
+							{
+								JunctionSet::Record & record = junction.Get(idx);
+								record.prev |= CharBit(pos > 0 ? CharAt(str, strand, pos - 1) : SEPARATION_CHAR);
+								record.next |= CharBit(pos + k_ < str.size() ? CharAt(str, strand, pos + k_) : SEPARATION_CHAR);
+							}
+							else if(idx != NO_RECORD && junction.Get(idx).id != NO_RECORD)
+							{
+								std::vector<BifurcationInstance> & ret = strand == 0 ? positiveBif : negativeBif;
+								ret.push_back(BifurcationInstance(static_cast<Size>(junction.Get(idx).id), static_cast<Size>(chr), static_cast<Size>(pos)));
+							}
+
+							if(pos + k_ < str.size())
+							{
+								window.Move();
+							}
+						}
+					}
+				}
+			}
+
+			if(pass == 0)
+			{
+				std::vector<size_t> bifurcation;
+				for(size_t i = 0; i < junction.Count(); i++)
+				{
+					if(Branching(junction.Get(i).prev) || Branching(junction.Get(i).next))
+					{
+						bifurcation.push_back(i);
+					}
+				}
+
+				std::sort(bifurcation.begin(), bifurcation.end(), JunctionLess(junction));
+				for(size_t i = 0; i < bifurcation.size(); i++)
+				{
+					junction.Get(bifurcation[i]).id = i;
+				}
+
+				bifurcationCount = bifurcation.size();
+				RecordPhaseValue("candidates", junction.Count());
+				RecordPhaseValue("bifurcations", bifurcation.size());
+			}
+		}
+
+		return bifurcationCount;
+	}
+}
@@ -11,6 +11,7 @@ namespace SyntenyFinder
 	namespace
 	{
 		const char EMPTY = ' ';
+		typedef ScratchVector<size_t>::Type ScratchSizeVector;
 
 		bool CmpSizePair(const std::pair<size_t, size_t> & a, const std::pair<size_t, size_t> & b)
 		{
@@ -36,34 +37,48 @@ namespace SyntenyFinder
 			}
 		};
 
+		//The walks along a branch are instantiated for each strand, the generic
+		//versions dispatch on the direction of the iterator
+		template<DNASequence::Direction direction>
+			size_t MaxBifurcationMultiplicity(const BifurcationStorage & bifStorage,
+				DNASequence::FixedStrandIterator<direction> it, size_t distance)
+			{
+				size_t ret = 0;
+				for(size_t i = 0; i < distance - 1; i++)
+				{
+					size_t bifId = bifStorage.GetBifurcation(++it);
+					if(bifId != BifurcationStorage::NO_BIFURCATION)
+					{
+						ret = std::max(ret, bifStorage.CountBifurcations(bifId));
+					}
+				}
+
+				return ret;
+			}
+
 		size_t MaxBifurcationMultiplicity(const BifurcationStorage & bifStorage,
 			StrandIterator it, size_t distance)
 		{
-			size_t ret = 0;
-			for(size_t i = 0; i < distance - 1; i++)
+			if(it.GetDirection() == DNASequence::positive)
 			{
-				size_t bifId = bifStorage.GetBifurcation(++it);
-				if(bifId != BifurcationStorage::NO_BIFURCATION)
-				{
-					ret = std::max(ret, bifStorage.CountBifurcations(bifId));
-				}
+				return MaxBifurcationMultiplicity(bifStorage, DNASequence::FixedStrandIterator<DNASequence::positive>(it), distance);
 			}
 
-			return ret;
+			return MaxBifurcationMultiplicity(bifStorage, DNASequence::FixedStrandIterator<DNASequence::negative>(it), distance);
 		}
 
 		void EraseBifurcations(DNASequence & sequence,
 			BifurcationStorage & bifStorage,
 			size_t k,
-			const IteratorProxyVector  & startKMer,
+			const ScratchProxyVector & startKMer,
 			VisitData targetData,
-			std::vector<std::pair<size_t, size_t> > & lookForward,
-			std::vector<std::pair<size_t, size_t> > & lookBack)
+			ScratchPairVector & lookForward,
+			ScratchPairVector & lookBack)
 		{
 			lookBack.clear();
 			lookForward.clear();
-			StrandIterator amer = AdvanceForward(*startKMer[targetData.kmerId], k).Invert();
-			StrandIterator bmer = AdvanceForward(*startKMer[targetData.kmerId], targetData.distance);
+			StrandIterator amer = sequence.AdvanceForward(*startKMer[targetData.kmerId], k).Invert();
+			StrandIterator bmer = sequence.AdvanceForward(*startKMer[targetData.kmerId], targetData.distance);
 			for(size_t i = 0; i < k; i++, ++amer, ++bmer)
 			{
 				size_t bifId = bifStorage.GetBifurcation(amer);
@@ -82,7 +97,7 @@ namespace SyntenyFinder
 			}
 
 			amer = *startKMer[targetData.kmerId];
-			bmer = AdvanceForward(amer, k + targetData.distance).Invert();
+			bmer = sequence.AdvanceForward(amer, k + targetData.distance).Invert();
 			for(size_t i = 0; i < k + targetData.distance; i++, ++amer, ++bmer)
 			{
 				if(i > 0)
@@ -94,113 +109,252 @@ namespace SyntenyFinder
 			}
 		}
 
+		void MarkPath(StrandIterator it, size_t length, bool value)
+		{
+			for(size_t i = 0; i < length; i++, ++it)
+			{
+				it.SetInfoBit(StrandIterator::MARK_BIT, value);
+			}
+		}
+
+		//The elements of the source branch are marked in place and looked up while
+		//walking the target one. There is only one spare bit in the metadata of an
+		//element, too few for a generation stamp, so the marks are cleared after
 		bool Overlap(size_t k,
-			const IteratorProxyVector & startKMer,
+			const ScratchProxyVector & startKMer,
 			VisitData sourceData,
 			VisitData targetData)
 		{
-			std::vector<size_t> occur;
-			StrandIterator it = *startKMer[sourceData.kmerId];
-			for(size_t i = 0; i < sourceData.distance + k; i++, ++it)
+			bool ret = false;
+			StrandIterator source = *startKMer[sourceData.kmerId];
+			MarkPath(source, sourceData.distance + k, true);
+			StrandIterator it = *startKMer[targetData.kmerId];
+			for(size_t i = 0; i < targetData.distance + k && !ret; i++, ++it)
 			{
-				occur.push_back(it.GetElementId());
+				ret = it.GetInfoBit(StrandIterator::MARK_BIT);
 			}
 
-			it = *startKMer[targetData.kmerId];
-			std::sort(occur.begin(), occur.end());
-			for(size_t i = 0; i < targetData.distance + k; i++, ++it)
+			MarkPath(source, sourceData.distance + k, false);
+			return ret;
+		}
+
+		typedef ScratchVector<BifurcationMark>::Type MarkVector;
+
+		//Bifurcations met on the branch in the order of the walk, "reach" is the
+		//first step that was not looked at
+		template<DNASequence::Direction direction>
+			size_t FillWalk(const BifurcationStorage & bifStorage,
+				DNASequence::FixedStrandIterator<direction> kmer,
+				size_t minBranchSize,
+				MarkVector & walk)
 			{
-				if(std::binary_search(occur.begin(), occur.end(), it.GetElementId()))
+				walk.clear();
+				size_t step = 1;
+				size_t start = bifStorage.GetBifurcation(kmer);
+				++kmer;
+				for(; step < minBranchSize && kmer.AtValidPosition(); ++kmer, step++)
 				{
-					return true;
+					size_t bifId = bifStorage.GetBifurcation(kmer);
+					if(bifId == start)
+					{
+						break;
+					}
+
+					if(bifId != BifurcationStorage::NO_BIFURCATION)
+					{
+						walk.push_back(BifurcationMark(bifId, step));
+					}
 				}
-			}
 
-			return false;
-		}
+				return step;
+			}
 
-		void FillVisit(const DNASequence & sequence,
-			const BifurcationStorage & bifStorage,
+		size_t FillWalk(const BifurcationStorage & bifStorage,
 			StrandIterator kmer,
 			size_t minBranchSize,
-			std::vector<BifurcationMark> & visit)
+			MarkVector & walk)
 		{
-			visit.clear();
-			size_t start = bifStorage.GetBifurcation(kmer);
-			++kmer;
-			for(size_t step = 1; step < minBranchSize && kmer.AtValidPosition(); ++kmer, step++)
+			if(kmer.GetDirection() == DNASequence::positive)
+			{
+				return FillWalk(bifStorage, DNASequence::FixedStrandIterator<DNASequence::positive>(kmer), minBranchSize, walk);
+			}
+
+			return FillWalk(bifStorage, DNASequence::FixedStrandIterator<DNASequence::negative>(kmer), minBranchSize, walk);
+		}
+
+		void FillVisit(const MarkVector & walk, MarkVector & visit)
+		{
+			visit.assign(walk.begin(), walk.end());
+			std::sort(visit.begin(), visit.end());
+		}
+
+		//Walks of the branches starting at the occurrences of a bifurcation. They are
+		//shared by all pairs of the branches and are taken again after a collapse
+		class BranchWalks
+		{
+		public:
+			BranchWalks(const BifurcationStorage & bifStorage, const ScratchProxyVector & startKMer, size_t minBranchSize, ScratchArena & arena):
+				bifStorage_(bifStorage), startKMer_(startKMer), minBranchSize_(minBranchSize),
+				walk_(startKMer.size(), MarkVector(ScratchAllocator<BifurcationMark>(arena)), ScratchAllocator<MarkVector>(arena)),
+				reach_(startKMer.size(), 0, ScratchAllocator<size_t>(arena)), done_(startKMer.size(), false, ScratchAllocator<Bool>(arena))
+			{
+			}
+
+			const MarkVector & Get(size_t kmerId)
 			{
-				size_t bifId = bifStorage.GetBifurcation(kmer);
-				if(bifId == start)
+				if(!done_[kmerId])
 				{
-					break;
+					reach_[kmerId] = FillWalk(bifStorage_, *startKMer_[kmerId], minBranchSize_, walk_[kmerId]);
+					done_[kmerId] = true;
 				}
 
-				if(bifId != BifurcationStorage::NO_BIFURCATION)
+				return walk_[kmerId];
+			}
+
+			//Same as MaxBifurcationMultiplicity, but takes the bifurcations from the walk
+			//if it went that far
+			size_t MaxMultiplicity(size_t kmerId, size_t distance)
+			{
+				const MarkVector & walk = Get(kmerId);
+				if(distance > reach_[kmerId])
 				{
-					visit.push_back(BifurcationMark(bifId, step));
+					return MaxBifurcationMultiplicity(bifStorage_, *startKMer_[kmerId], distance);
 				}
+
+				size_t ret = 0;
+				for(size_t i = 0; i < walk.size() && walk[i].distance < distance; i++)
+				{
+					ret = std::max(ret, bifStorage_.CountBifurcations(walk[i].bifId));
+				}
+
+				return ret;
 			}
 
-			std::sort(visit.begin(), visit.end());
-		}
+			void Invalidate()
+			{
+				std::fill(done_.begin(), done_.end(), false);
+			}
+
+		private:
+			const BifurcationStorage & bifStorage_;
+			const ScratchProxyVector & startKMer_;
+			size_t minBranchSize_;
+			ScratchVector<MarkVector>::Type walk_;
+			ScratchSizeVector reach_;
+			ScratchVector<Bool>::Type done_;
+		};
 		
+		void MarkDirty(const BifurcationStorage & bifStorage, StrandIterator it, std::vector<Bool> & dirty)
+		{
+			size_t bifId = bifStorage.GetBifurcation(it);
+			if(bifId != BifurcationStorage::NO_BIFURCATION)
+			{
+				dirty[bifId] = true;
+			}
+		}
+
+		//Marks the bifurcations inside the branch of the collapse and the ones that
+		//are less than "window" chars before it, on both strands. The region of the
+		//branch covers all the points that the collapse erases and adds
+		void MarkBranch(const BifurcationStorage & bifStorage, size_t k, StrandIterator begin, size_t distance, size_t window, std::vector<Bool> & dirty)
+		{
+			StrandIterator end = begin;
+			size_t length = distance + 2 * k + 2;
+			for(size_t i = 0; i < length && end.AtValidPosition(); i++, ++end);
+			StrandIterator start[] = {begin, end.Invert()};
+			for(size_t strand = 0; strand < 2; strand++)
+			{
+				StrandIterator it = start[strand];
+				for(size_t i = 0; i <= window && it.AtValidPosition(); i++, --it)
+				{
+					MarkDirty(bifStorage, it, dirty);
+				}
+
+				it = start[strand];
+				for(size_t i = 0; i <= length && it.AtValidPosition(); i++, ++it)
+				{
+					MarkDirty(bifStorage, it, dirty);
+				}
+			}
+		}
+
 		struct BranchData
 		{
-			BranchData() {}
-			BranchData(char ch): endChar(ch) {}
+			BranchData(char ch, ScratchArena & arena): endChar(ch), branchIds(ScratchAllocator<size_t>(arena)) {}
 			char endChar;
-			std::vector<size_t> branchIds;
+			ScratchSizeVector branchIds;
 		};
 
-		typedef std::vector< std::vector<size_t> > BulgedBranches;
+		typedef ScratchVector<ScratchSizeVector>::Type BulgedBranches;
+		typedef std::pair<const size_t, BranchData> BranchRecord;
+		typedef boost::unordered_map<size_t, BranchData, boost::hash<size_t>, std::equal_to<size_t>, ScratchAllocator<BranchRecord> > BranchMap;
+
+		template<DNASequence::Direction direction>
+			void VisitBranch(const BifurcationStorage & bifStorage,
+				DNASequence::FixedStrandIterator<direction> kmer,
+				size_t minBranchSize,
+				size_t branchId,
+				char endChar,
+				BranchMap & visit,
+				ScratchArena & arena)
+			{
+				size_t start = bifStorage.GetBifurcation(kmer);
+				++kmer;
+				for(size_t step = 1; step < minBranchSize && kmer.AtValidPosition(); ++kmer, step++)
+				{
+					size_t bifId = bifStorage.GetBifurcation(kmer);
+					if(bifId == start)
+					{
+						break;
+					}
+
+					if(bifId != BifurcationStorage::NO_BIFURCATION)
+					{
+						BranchMap::iterator kt = visit.find(bifId);
+						if(kt == visit.end())
+						{
+							BranchData bData(endChar, arena);
+							bData.branchIds.push_back(branchId);
+							visit.insert(std::make_pair(bifId, bData));//endChar[i];
+						}
+						else if(kt->second.endChar != endChar)
+						{
+							kt->second.branchIds.push_back(branchId);
+							break;
+						}
+					}
+				}
+			}
 
 		bool AnyBulges(DNASequence & sequence,
 			BifurcationStorage & bifStorage,
 			size_t k,
-			const IteratorProxyVector & startKMer,
-			const std::vector<char> & endChar,
+			const ScratchProxyVector & startKMer,
+			const ScratchVector<char>::Type & endChar,
 			BulgedBranches & bulges,
-			size_t minBranchSize)
+			size_t minBranchSize,
+			ScratchArena & arena)
 		{
 			//bool result = false;
 			bulges.clear();
-			boost::unordered_map<size_t, BranchData> visit;
+			BranchMap visit((ScratchAllocator<BranchRecord>(arena)));
 			for(size_t i = 0; i < startKMer.size(); i++)
 			{
 				if(endChar[i] != EMPTY)
 				{
 					StrandIterator kmer = *startKMer[i];
-					size_t start = bifStorage.GetBifurcation(kmer);
-					++kmer;
-					for(size_t step = 1; step < minBranchSize && kmer.AtValidPosition(); ++kmer, step++)
+					if(kmer.GetDirection() == DNASequence::positive)
 					{
-						size_t bifId = bifStorage.GetBifurcation(kmer);
-						if(bifId == start)
-						{
-							break;
-						}
-
-						if(bifId != BifurcationStorage::NO_BIFURCATION)
-						{
-							boost::unordered_map<size_t, BranchData>::iterator kt = visit.find(bifId);
-							if(kt == visit.end())
-							{
-								BranchData bData(endChar[i]);
-								bData.branchIds.push_back(i);
-								visit[bifId] = bData;//endChar[i];
-							}
-							else if(kt->second.endChar != endChar[i])
-							{
-								kt->second.branchIds.push_back(i);
-								break;
-							}
-						}
+						VisitBranch(bifStorage, DNASequence::FixedStrandIterator<DNASequence::positive>(kmer), minBranchSize, i, endChar[i], visit, arena);
+					}
+					else
+					{
+						VisitBranch(bifStorage, DNASequence::FixedStrandIterator<DNASequence::negative>(kmer), minBranchSize, i, endChar[i], visit, arena);
 					}
 				}
 			}
 
-			for (boost::unordered_map<size_t, BranchData>::iterator kt = visit.begin(); kt !=visit.end(); ++kt)
+			for (BranchMap::iterator kt = visit.begin(); kt !=visit.end(); ++kt)
 			{
 				if (kt->second.branchIds.size() > 1)
 				{
@@ -238,16 +392,16 @@ namespace SyntenyFinder
 	void BlockFinder::UpdateBifurcations(DNASequence & sequence,
 			BifurcationStorage & bifStorage,
 			size_t k,
-			const IteratorProxyVector & startKMer,
+			const ScratchProxyVector & startKMer,
 			VisitData sourceData,
 			VisitData targetData,
-			const std::vector<std::pair<size_t, size_t> > & lookForward,
-			const std::vector<std::pair<size_t, size_t> > & lookBack)
+			const ScratchPairVector & lookForward,
+			const ScratchPairVector & lookBack)
 	{
 		size_t anear = 0;
 		size_t bnear = 0;
-		StrandIterator amer = AdvanceForward(*startKMer[targetData.kmerId], k).Invert();
-		StrandIterator bmer = AdvanceForward(*startKMer[targetData.kmerId], sourceData.distance);
+		StrandIterator amer = sequence.AdvanceForward(*startKMer[targetData.kmerId], k).Invert();
+		StrandIterator bmer = sequence.AdvanceForward(*startKMer[targetData.kmerId], sourceData.distance);
 		for(size_t i = 0; i < k; i++, ++amer, ++bmer)
 		{
 			if(anear < lookBack.size() && i == lookBack[anear].first)
@@ -262,9 +416,9 @@ namespace SyntenyFinder
 		}
 
 		amer = *startKMer[targetData.kmerId];
-		bmer = AdvanceForward(*startKMer[targetData.kmerId], sourceData.distance + k).Invert();
+		bmer = sequence.AdvanceForward(*startKMer[targetData.kmerId], sourceData.distance + k).Invert();
 		StrandIterator srcAMer = *startKMer[sourceData.kmerId];
-		StrandIterator srcBMer = AdvanceForward(*startKMer[sourceData.kmerId], sourceData.distance + k).Invert();
+		StrandIterator srcBMer = sequence.AdvanceForward(*startKMer[sourceData.kmerId], sourceData.distance + k).Invert();
 		for(size_t i = 0; i < sourceData.distance + 1; i++, ++amer, ++bmer, ++srcAMer, ++srcBMer)
 		{
 			size_t bifId = bifStorage.GetBifurcation(srcAMer);
@@ -284,7 +438,7 @@ namespace SyntenyFinder
 	void BlockFinder::CollapseBulgeGreedily(DNASequence & sequence,
 		BifurcationStorage & bifStorage,
 		size_t k,
-		IteratorProxyVector & startKMer,
+		ScratchProxyVector & startKMer,
 		VisitData sourceData,
 		VisitData targetData)
 	{
@@ -300,17 +454,16 @@ namespace SyntenyFinder
 		bifStorage.Dump(sequence, k, std::cerr);
 		iseq_->Test();
 	#endif
-		std::vector<std::pair<size_t, size_t> > lookForward;
-		std::vector<std::pair<size_t, size_t> > lookBack;
+		ScratchPairVector lookForward((ScratchAllocator<std::pair<size_t, size_t> >(*scratch_)));
+		ScratchPairVector lookBack((ScratchAllocator<std::pair<size_t, size_t> >(*scratch_)));
 		EraseBifurcations(sequence, bifStorage, k, startKMer, targetData, lookForward, lookBack);
 		StrandIterator sourceIt = *startKMer[sourceData.kmerId];
 		StrandIterator targetIt = *startKMer[targetData.kmerId];
-		sequence.Replace(AdvanceForward(sourceIt, k),
+		sequence.Replace(sequence.AdvanceForward(sourceIt, k),
 			sourceData.distance,
-			AdvanceForward(targetIt, k),
+			sequence.AdvanceForward(targetIt, k),
 			targetData.distance,
-			boost::bind(&BifurcationStorage::NotifyBefore, boost::ref(bifStorage), _1, _2),
-			boost::bind(&BifurcationStorage::NotifyAfter, boost::ref(bifStorage), _1, _2));
+			bifStorage);
 		UpdateBifurcations(sequence, bifStorage, k, startKMer, sourceData, targetData, lookForward, lookBack);
 
 	#ifdef _DEBUG
@@ -328,32 +481,35 @@ namespace SyntenyFinder
 
 
 	size_t BlockFinder::RemoveBulges(DNASequence & sequence,
-		BifurcationStorage & bifStorage, size_t k, size_t minBranchSize, size_t bifId)
+		BifurcationStorage & bifStorage, size_t k, size_t minBranchSize, size_t bifId, std::vector<Bool> & dirty)
 	{
+		HotPathScope hotPath;
 		size_t ret = 0;
-		IteratorProxyVector startKMer;
+		scratch_->Reset();
+		ScratchProxyVector startKMer((ScratchAllocator<BifurcationStorage::IteratorProxy>(*scratch_)));
 		if(bifStorage.ListPositions(bifId, std::back_inserter(startKMer)) < 2)
 		{
 			return ret;
 		}
 
-		std::vector<char> endChar(startKMer.size(), EMPTY);
+		ScratchVector<char>::Type endChar(startKMer.size(), EMPTY, ScratchAllocator<char>(*scratch_));
 		for(size_t i = 0; i < startKMer.size(); i++)
 		{
 			if(ProperKMer(*startKMer[i], k + 1))
 			{
-				endChar[i] = *AdvanceForward(*startKMer[i], k);
+				endChar[i] = *sequence.AdvanceForward(*startKMer[i], k);
 			}
 		}
 
 		//std::vector<bool> isBulge(startKMer.size(), false);
-		BulgedBranches bulges;
-		if(!AnyBulges(sequence, bifStorage, k, startKMer, endChar, bulges, minBranchSize))
+		BulgedBranches bulges((ScratchAllocator<ScratchSizeVector>(*scratch_)));
+		if(!AnyBulges(sequence, bifStorage, k, startKMer, endChar, bulges, minBranchSize, *scratch_))
 		{
 			return ret;
 		}
 
-		std::vector<BifurcationMark> visit;
+		MarkVector visit((ScratchAllocator<BifurcationMark>(*scratch_)));
+		BranchWalks walks(bifStorage, startKMer, minBranchSize, *scratch_);
 		for (size_t numBulge = 0; numBulge < bulges.size(); ++numBulge)
 		{
 
@@ -368,7 +524,7 @@ namespace SyntenyFinder
 					continue;
 				}
 
-				FillVisit(sequence, bifStorage, *startKMer[kmerI], minBranchSize, visit);
+				FillVisit(walks.Get(kmerI), visit);
 				//for(size_t kmerJ = kmerI + 1; kmerJ < startKMer.size(); kmerJ++)
 				for(size_t  idJ = idI + 1; idJ < bulges[numBulge].size(); ++idJ)
 				{
@@ -380,45 +536,46 @@ namespace SyntenyFinder
 						continue;
 					}
 
-					StrandIterator kmer = ++StrandIterator(*startKMer[kmerJ]);
-					for(size_t step = 1; kmer.AtValidPosition() && step < minBranchSize; ++kmer, step++)
+					//The walk ends before the next occurrence of bifId
+					const MarkVector & branch = walks.Get(kmerJ);
+					for(size_t w = 0; w < branch.size(); w++)
 					{
-						size_t nowBif = bifStorage.GetBifurcation(kmer);
-						if(nowBif != BifurcationStorage::NO_BIFURCATION)
+						size_t nowBif = branch[w].bifId;
+						MarkVector::iterator vt = std::lower_bound(visit.begin(), visit.end(), BifurcationMark(nowBif, 0));
+						if(vt != visit.end() && vt->bifId == nowBif)
 						{
-							if(nowBif == bifId)
+							VisitData jdata(kmerJ, branch[w].distance);
+							VisitData idata(kmerI, vt->distance);
+							if(Overlap(k, startKMer, idata, jdata))
 							{
 								break;
 							}
 
-							std::vector<BifurcationMark>::iterator vt = std::lower_bound(visit.begin(), visit.end(), BifurcationMark(nowBif, 0));
-							if(vt != visit.end() && vt->bifId == nowBif)
+							++ret;
+							size_t imlp = walks.MaxMultiplicity(kmerI, idata.distance);
+							size_t jmlp = walks.MaxMultiplicity(kmerJ, jdata.distance);
+							bool iless = imlp > jmlp || (imlp == jmlp && idata.kmerId < jdata.kmerId);
+							//The walks of RemoveBulges look minBranchSize + k chars ahead
+							size_t window = minBranchSize + k + 1;
+							if(iless)
 							{
-								VisitData jdata(kmerJ, step);
-								VisitData idata(kmerI, vt->distance);
-								if(Overlap(k, startKMer, idata, jdata) || nowBif == bifId)
-								{
-									break;
-								}
-
-								++ret;
-								size_t imlp = MaxBifurcationMultiplicity(bifStorage, *startKMer[kmerI], idata.distance);
-								size_t jmlp = MaxBifurcationMultiplicity(bifStorage, *startKMer[kmerJ], jdata.distance);
-								bool iless = imlp > jmlp || (imlp == jmlp && idata.kmerId < jdata.kmerId);
-								if(iless)
-								{
-									endChar[jdata.kmerId] = endChar[idata.kmerId];
-									CollapseBulgeGreedily(sequence, bifStorage, k, startKMer, idata, jdata);
-								}
-								else
-								{
-									endChar[idata.kmerId] = endChar[jdata.kmerId];
-									CollapseBulgeGreedily(sequence, bifStorage, k, startKMer, jdata, idata);
-									FillVisit(sequence, bifStorage, *startKMer[kmerI], minBranchSize, visit);
-								}
-
-								break;
+								endChar[jdata.kmerId] = endChar[idata.kmerId];
+								MarkBranch(bifStorage, k, *startKMer[jdata.kmerId], jdata.distance, 0, dirty);
+								CollapseBulgeGreedily(sequence, bifStorage, k, startKMer, idata, jdata);
+								MarkBranch(bifStorage, k, *startKMer[jdata.kmerId], idata.distance, window, dirty);
+								walks.Invalidate();
+							}
+							else
+							{
+								endChar[idata.kmerId] = endChar[jdata.kmerId];
+								MarkBranch(bifStorage, k, *startKMer[idata.kmerId], idata.distance, 0, dirty);
+								CollapseBulgeGreedily(sequence, bifStorage, k, startKMer, jdata, idata);
+								MarkBranch(bifStorage, k, *startKMer[idata.kmerId], jdata.distance, window, dirty);
+								walks.Invalidate();
+								FillVisit(walks.Get(kmerI), visit);
 							}
+
+							break;
 						}
 					}
 				}
@@ -9,6 +9,8 @@ import shutil
 import tempfile
 import argparse
 import itertools
+import struct
+import mmap
 import functools
 import subprocess
 import collections
@@ -337,15 +339,53 @@ def depict_coverage(block_seq, reference_seq, assembly_seq, base_cover):
 				base_cover[instance.chr_id][start:end] = [block_id] * (end - start)
 	return base_cover
 
+def parse_blocks_coords_bin(blocks_file, genome):
+	handle = open(blocks_file, 'rb')
+	data = mmap.mmap(handle.fileno(), 0, access=mmap.ACCESS_READ)
+	header = struct.unpack_from('<8sIIII5Q', data, 0)
+	if header[0] != b'SIBBLKS1' or header[1] != 1:
+		raise ValueError('Unsupported blocks coordinates file ' + blocks_file)
+	chr_number, instance_number = header[2:4]
+	record_offset, chr_table = header[5], header[9]
+	num_seq_id = dict()
+	num_seq_size = dict()
+	for chr_num in range(1, chr_number + 1):
+		size, length = struct.unpack_from('<QI', data, chr_table)
+		chr_table += 12
+		num_seq_id[chr_num] = data[chr_table:chr_table + length].decode('ascii').split()[0]
+		num_seq_size[chr_num] = size
+		chr_table += length
+	ret = dict()
+	for i in range(instance_number):
+		signed_id, chr, start, end = struct.unpack_from('<iIII', data, record_offset + i * 16)
+		block_id = abs(signed_id)
+		chr_num = chr + 1
+		strand = '+' if signed_id > 0 else '-'
+		true_start = min(start, end) - 1
+		true_end = max(start, end)
+		seq = genome[chr].seq[true_start:true_end]
+		if strand == '-':
+			seq = reverse_complementary(seq)
+		ret.setdefault(block_id, []).append(SyntenyBlock(seq=seq, chr_id=num_seq_id[chr_num], strand=strand, id=block_id,
+						start=start, end=end, chr_num=chr_num, chr_size=num_seq_size[chr_num]))
+	data.close()
+	handle.close()
+	return ret
+
 def coords_key(file_name):
 	return int(file_name.split('.')[0][13:])
 
 def call_variants(directory, genomes, reference_seq, assembly_seq, min_block_size, proc_num, align):
 	os.chdir(directory)
-	coords_file_re = re.compile('blocks_coords[0-9]*.txt')
+	parse = parse_blocks_coords_bin
+	coords_file_re = re.compile('blocks_coords[0-9]*.bin')
 	coords_file_list = [coords_file for coords_file in os.listdir('.') if coords_file_re.match(coords_file)]
+	if not coords_file_list:
+		parse = parse_blocks_coords
+		coords_file_re = re.compile('blocks_coords[0-9]*.txt')
+		coords_file_list = [coords_file for coords_file in os.listdir('.') if coords_file_re.match(coords_file)]
 	coords_file_list.sort(key=coords_key)
-	blocks_coords = [parse_blocks_coords(file_name, genomes) for file_name in coords_file_list]
+	blocks_coords = [parse(file_name, genomes) for file_name in coords_file_list]
 	pool = multiprocessing.Pool(proc_num)
 	annotated_block = []
 	for synteny_block_id, instance_list in blocks_coords[-1].items():
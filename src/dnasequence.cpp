@@ -5,9 +5,16 @@
 //****************************************************************************
 
 #include "dnasequence.h"
+#include "runstats.h"
 
 namespace SyntenyFinder
 {
+	namespace
+	{
+		//Shorter steps are faster to make one by one, see unrolledlist-bench
+		const size_t INDEX_STEP = 512;
+	}
+
 	inline std::string ConstructComplementarityTable()
 	{
 		std::string ret(1 << (sizeof(char) * 8), ' ');
@@ -100,6 +107,7 @@ namespace SyntenyFinder
 
 		std::for_each(posBegin_.begin(), posBegin_.end(), boost::bind(&DNASequence::SubscribeIterator, boost::ref(*this), _1));
 		std::for_each(posEnd_.begin(), posEnd_.end(), boost::bind(&DNASequence::SubscribeIterator, boost::ref(*this), _1));
+		TagChunks(++sequence_.begin(), sequence_.size());
 	}
 	
 	size_t DNASequence::TotalSize() const
@@ -114,119 +122,145 @@ namespace SyntenyFinder
 	
 	void DNASequence::SubscribeIterator(SequencePosIterator & it)
 	{
-		iteratorStore_.insert(&it);
+		SubscriberGroup * group = FindSubscribers(it.get_chunk_id());
+		if(group == 0)
+		{
+			if(freeGroup_.empty())
+			{
+				freeGroup_.push_back(static_cast<Size>(subscriber_.size()));
+				subscriber_.push_back(SubscriberGroup());
+			}
+
+			subscriberGroup_.Insert(it.get_chunk_id(), freeGroup_.back());
+			group = &subscriber_[freeGroup_.back()];
+			freeGroup_.pop_back();
+		}
+
+		group->push_back(&it);
 	}
 
 	void DNASequence::UnsubscribeIterator(SequencePosIterator & it)
 	{		
-		for(IteratorRange range = iteratorStore_.equal_range(&it); range.first != range.second; ++range.first)
+		SubscriberGroup * group = FindSubscribers(it.get_chunk_id());
+		if(group != 0)
 		{
-			if(*range.first == &it)
+			group->erase(std::remove(group->begin(), group->end(), &it), group->end());
+			if(group->empty())
 			{
-				range.first = iteratorStore_.erase(range.first);
+				ReleaseSubscribers(it.get_chunk_id());
 			}
 		}
 	}
 
-	void DNASequence::NotifyBefore(SequencePosIterator begin, SequencePosIterator end, NotifyFunction before)
-	{	
-		if(before)
-		{
-			SequencePosIterator nowBegin = begin;
-			while(nowBegin != end)
-			{
-				SequencePosIterator nowEnd = nowBegin;
-				for(; nowEnd != end && nowEnd->actual != SEPARATION_CHAR; ++nowEnd);
-				StrandIterator pbegin(nowBegin, positive);
-				StrandIterator pend(nowEnd, positive);
-				before(pbegin, pend);
-				before(pend.Invert(), pbegin.Invert());
-				nowBegin = nowEnd != end ? ++nowEnd : nowEnd;
-			}			
-		}
+	DNASequence::SubscriberGroup * DNASequence::FindSubscribers(const void * chunk)
+	{
+		const Size * group = subscriberGroup_.Find(chunk);
+		return group == 0 ? 0 : &subscriber_[*group];
+	}
 
-		for(; begin != end; ++begin)
-		{			
-			toReplace_.push_back(iteratorStore_.find(&begin));
+	void DNASequence::ReleaseSubscribers(const void * chunk)
+	{
+		Size group;
+		if(subscriberGroup_.Erase(chunk, group))
+		{
+			freeGroup_.push_back(group);
 		}
 	}
 
-	void DNASequence::NotifyAfter(SequencePosIterator begin, SequencePosIterator end, NotifyFunction after)
-	{	
-		if(after)
+	//The list moves elements only within a chunk, so the whole range has one group
+	void DNASequence::DetachSubscribers(SequencePosIterator begin, SequencePosIterator end)
+	{
+		const void * chunk = begin.get_chunk_id();
+		SubscriberGroup * group = FindSubscribers(chunk);
+		if(group == 0)
 		{
-			SequencePosIterator nowBegin = begin;
-			while(nowBegin != end)
-			{
-				SequencePosIterator nowEnd = nowBegin;
-				for(; nowEnd != end && nowEnd->actual != SEPARATION_CHAR; ++nowEnd);
-				StrandIterator pbegin(nowBegin, positive);
-				StrandIterator pend(nowEnd, positive);
-				after(pbegin, pend);
-				after(pend.Invert(), pbegin.Invert());
-				nowBegin = nowEnd != end ? ++nowEnd : nowEnd;
-			}			
+			return;
 		}
 
-		size_t pos = 0;
-		std::vector<boost::reference_wrapper<SequencePosIterator> > resubscribe;
-		for(; begin != end; ++begin, ++pos)
+		for(size_t pos = 0; begin != end && !group->empty(); ++begin, ++pos)
 		{
-			if(toReplace_[pos] != iteratorStore_.end())
+			assert(begin.get_chunk_id() == chunk);
+			for(size_t i = 0; i < group->size(); )
 			{
-				IteratorPlace it = toReplace_[pos];
-				**it = begin;
-				resubscribe.push_back(boost::ref(**it));
-				it = iteratorStore_.erase(it);
+				if(*(*group)[i] == begin)
+				{
+					moved_.push_back(std::make_pair(pos, (*group)[i]));
+					(*group)[i] = group->back();
+					group->pop_back();
+				}
+				else
+				{
+					++i;
+				}
 			}
 		}
 
-		toReplace_.clear();
-		assert(posEnd_.back() == --sequence_.end());
-		std::for_each(resubscribe.begin(), resubscribe.end(), boost::bind(&DNASequence::SubscribeIterator, boost::ref(*this), _1));
+		if(group->empty())
+		{
+			ReleaseSubscribers(chunk);
+		}
 	}
 
-	DNASequence::SequencePosIterator DNASequence::ReplaceDirect(StrandIterator source,
-			size_t sourceDistance, 
-			SequencePosIterator target,
-			size_t targetDistance,
-			NotifyFunction before,
-			NotifyFunction after)
-	{	
-		StrandIterator save = StrandIterator(target, positive);
-		size_t firstPos = save.GetOriginalPosition();
-		size_t lastPos = AdvanceForward(save, targetDistance).GetOriginalPosition();
-		for(size_t i = 0; i < std::min(sourceDistance, targetDistance); i++)
+	void DNASequence::AttachSubscribers(SequencePosIterator begin)
+	{
+		size_t pos = 0;
+		for(size_t i = 0; i < moved_.size(); i++)
 		{
-			*target = *source;
-			++target;
-			++source;
+			for(; pos < moved_[i].first; ++pos, ++begin);
+			*moved_[i].second = begin;
+			SubscribeIterator(*moved_[i].second);
 		}
 
-		if(sourceDistance < targetDistance)
+		moved_.clear();
+		assert(posEnd_.back() == --sequence_.end());
+	}
+
+	//The tag of a chunk is the number of separators before it, the separators
+	//are never inserted or erased. So only new chunks and the chunk that got
+	//the moved elements on insertion need a new tag: they follow the inserted
+	//elements "it", the chunk of the element before "it" has the right tag
+	void DNASequence::TagChunks(SequencePosIterator it, size_t count)
+	{
+		SequencePosIterator prev = it;
+		--prev;
+		size_t separators = SeparatorsBefore(prev) + (prev->actual == SEPARATION_CHAR ? 1 : 0);
+		const void * chunk = prev.get_chunk_id();
+		for(size_t step = 0; it != sequence_.end(); ++it, ++step)
 		{
-			SequencePosIterator targetEnd = AdvanceForward(target, targetDistance - sourceDistance);
-			target = sequence_.erase(target, targetEnd);			
-		}
-		else if(sourceDistance != targetDistance)
-		{			
-			Sequence::notify_func seqBefore = boost::bind(&DNASequence::NotifyBefore, boost::ref(*this), _1, _2, before);
-			Sequence::notify_func seqAfter = boost::bind(&DNASequence::NotifyAfter, boost::ref(*this), _1, _2, after);
-			StrandIterator sourceEnd = AdvanceForward(source, sourceDistance - targetDistance);
-			std::string buf(source, sourceEnd);			
-			target = sequence_.insert(target, buf.begin(), buf.end(), seqBefore, seqAfter);
-			target = AdvanceForward(target, sourceDistance - targetDistance);
+			if(it.get_chunk_id() != chunk)
+			{
+				if(step > count)
+				{
+					break;
+				}
+
+				chunk = it.get_chunk_id();
+				it.get_chunk_tag() = static_cast<PaddingInt>(separators);
+			}
+
+			if(it->actual == SEPARATION_CHAR)
+			{
+				++separators;
+			}
 		}
+	}
 
-		double acc = static_cast<double>(firstPos);
-		double ssize = double(targetDistance) / sourceDistance;
-		for(size_t step = 0; step < sourceDistance; step++, ++save, acc += ssize)
+	size_t DNASequence::SeparatorsBefore(SequencePosIterator jt) const
+	{
+		const void * chunk = jt.get_chunk_id();
+		size_t ret = jt.get_chunk_tag();
+		for(SequencePosIterator begin = const_cast<DNASequence*>(this)->sequence_.begin(); jt != begin && (--jt).get_chunk_id() == chunk; )
 		{
-			size_t pos = std::min(lastPos, size_t(acc));
-			save.SetOriginalPosition(pos);
+			ret += jt->actual == SEPARATION_CHAR ? 1 : 0;
 		}
 
-		return target;
+		return ret;
+	}
+
+	size_t DNASequence::GetChr(StrandIterator it) const
+	{
+		//The sequence starts with a separator
+		return SeparatorsBefore(it.Base()) - 1;
 	}
 
 	void DNASequence::Replace(StrandIterator source,
@@ -236,19 +270,8 @@ namespace SyntenyFinder
 			NotifyFunction before,
 			NotifyFunction after)
 	{	
-		if(target.GetDirection() == positive)
-		{
-			SequencePosIterator begin = target.Base();
-			begin = ReplaceDirect(source, sourceDistance, begin, targetDistance, before, after);
-			target = AdvanceBackward(StrandIterator(begin, positive), sourceDistance);
-		}
-		else
-		{
-			source = AdvanceForward(source, sourceDistance).Invert();
-			SequencePosIterator begin = AdvanceForward(target, targetDistance).Invert().Base();
-			begin = ReplaceDirect(source, sourceDistance, begin, targetDistance, before, after);
-			target = StrandIterator(--begin, negative);
-		}
+		FunctionObserver observer(before, after);
+		Replace(source, sourceDistance, target, targetDistance, observer);
 	}
 
 	std::pair<size_t, size_t> DNASequence::SpellOriginal(StrandIterator it1, StrandIterator it2) const
@@ -268,6 +291,30 @@ namespace SyntenyFinder
 
 	size_t DNASequence::GlobalIndex(StrandIterator it) const
 	{
-		return std::distance(++(const_cast<DNASequence*>(this)->sequence_.begin()), it.Base());
+		return const_cast<DNASequence*>(this)->sequence_.index_of(it.Base()) - 1;
+	}
+
+	DNASequence::StrandIterator DNASequence::AdvanceForward(StrandIterator it, size_t step) const
+	{
+		if(step < INDEX_STEP)
+		{
+			return SyntenyFinder::AdvanceForward(it, step);
+		}
+
+		Sequence & sequence = const_cast<DNASequence*>(this)->sequence_;
+		size_t index = sequence.index_of(it.Base());
+		return StrandIterator(sequence.at(it.GetDirection() == positive ? index + step : index - step), it.GetDirection());
+	}
+
+	DNASequence::StrandIterator DNASequence::AdvanceBackward(StrandIterator it, size_t step) const
+	{
+		if(step < INDEX_STEP)
+		{
+			return SyntenyFinder::AdvanceBackward(it, step);
+		}
+
+		Sequence & sequence = const_cast<DNASequence*>(this)->sequence_;
+		size_t index = sequence.index_of(it.Base());
+		return StrandIterator(sequence.at(it.GetDirection() == positive ? index - step : index + step), it.GetDirection());
 	}
 }
\ No newline at end of file
@@ -10,6 +10,8 @@
 #include "fasta.h"
 #include "common.h"
 #include "unrolledlist.h"
+#include "runstats.h"
+#include "addressmap.h"
 
 #pragma warning(disable:4355)
 
@@ -52,6 +54,8 @@ namespace SyntenyFinder
 		{
 		public:
 			static const Size INFO_BITS;
+			//Info bit that the bifurcation storage does not use, for short-lived marks
+			static const Size MARK_BIT;
 			void MakeInverted();
 			void Swap(StrandIterator & toSwap);
 			char operator * () const;
@@ -84,6 +88,86 @@ namespace SyntenyFinder
 			Direction direction_;
 		};
 
+		//StrandIterator with the direction fixed at compile time, for the loops that
+		//stay on one strand. Converts to and from StrandIterator of the same direction
+		template<Direction direction>
+			class FixedStrandIterator: public std::iterator<std::bidirectional_iterator_tag, char, size_t>
+			{
+			public:
+				FixedStrandIterator() {}
+				explicit FixedStrandIterator(StrandIterator it): it_(it.Base())
+				{
+					assert(it.GetDirection() == direction);
+				}
+
+				char operator * () const
+				{
+					return direction == positive ? it_->actual : complementary_[it_->actual];
+				}
+
+				FixedStrandIterator& operator ++ ()
+				{
+					assert(AtValidPosition());
+					if(direction == positive)
+					{
+						++it_;
+					}
+					else
+					{
+						--it_;
+					}
+
+					return *this;
+				}
+
+				FixedStrandIterator& operator -- ()
+				{
+					if(direction == positive)
+					{
+						--it_;
+					}
+					else
+					{
+						++it_;
+					}
+
+					return *this;
+				}
+
+				bool operator == (const FixedStrandIterator & comp) const
+				{
+					return it_ == comp.it_;
+				}
+
+				bool operator != (const FixedStrandIterator & comp) const
+				{
+					return it_ != comp.it_;
+				}
+
+				bool AtValidPosition() const
+				{
+					return it_->actual != SEPARATION_CHAR;
+				}
+
+				bool GetInfoBit(size_t bit) const
+				{
+					return (it_.meta() & (Size(1) << (sizeof(Size) * 8 - 1 - bit))) != 0;
+				}
+
+				SequencePosIterator Base() const
+				{
+					return it_;
+				}
+
+				StrandIterator Get() const
+				{
+					return StrandIterator(it_, direction);
+				}
+
+			private:
+				SequencePosIterator it_;
+			};
+
 		typedef boost::function<void(StrandIterator, StrandIterator)> NotifyFunction;
 		
 		void Clear();
@@ -102,9 +186,22 @@ namespace SyntenyFinder
 			size_t targetDistance,
 			NotifyFunction before = 0,
 			NotifyFunction after = 0);
+		//Same, but the observer is called directly: observer.NotifyBefore(begin, end) and
+		//observer.NotifyAfter(begin, end) get the elements moved by the list on each strand
+		template<class Observer>
+			void Replace(StrandIterator source,
+				size_t sourceDistance, 
+				StrandIterator target,
+				size_t targetDistance,
+				Observer & observer);
 		DNASequence(const std::vector<std::string> & record, std::vector<std::vector<Pos> > & original, bool clear = false);
 		std::pair<size_t, size_t> SpellOriginal(StrandIterator it1, StrandIterator it2) const;
 		size_t GlobalIndex(StrandIterator it) const;		
+		//Chromosome of the element in O(1), see TagChunks
+		size_t GetChr(StrandIterator it) const;
+		//Same as the generic ones, long steps go through the index of the list in O(log n)
+		StrandIterator AdvanceForward(StrandIterator it, size_t step) const;
+		StrandIterator AdvanceBackward(StrandIterator it, size_t step) const;
 		static const char UNKNOWN_BASE;
 	private:
 		DISALLOW_COPY_AND_ASSIGN(DNASequence);
@@ -113,43 +210,175 @@ namespace SyntenyFinder
 		static const Pos DELETED_POS;
 		static const std::string complementary_;
 
-		struct IteratorPtrHash
+		//Observer calling the functions if they are set
+		class FunctionObserver
 		{
-			size_t operator()(SequencePosIterator * it) const
+		public:
+			FunctionObserver(NotifyFunction before, NotifyFunction after): before_(before), after_(after) {}
+			void NotifyBefore(StrandIterator begin, StrandIterator end)
 			{
-				return reinterpret_cast<size_t>(&(**it));
+				if(before_)
+				{
+					before_(begin, end);
+				}
 			}
-		};
 
-		struct IteratorPtrCompare
-		{
-			bool operator()(SequencePosIterator * it, SequencePosIterator * jt) const
+			void NotifyAfter(StrandIterator begin, StrandIterator end)
 			{
-				return (*it) == (*jt);
+				if(after_)
+				{
+					after_(begin, end);
+				}
 			}
+
+		private:
+			NotifyFunction before_;
+			NotifyFunction after_;
 		};
 
-		typedef boost::unordered_set<SequencePosIterator*, IteratorPtrHash, IteratorPtrCompare> IteratorMap;
-		typedef IteratorMap::iterator IteratorPlace;
-		typedef std::pair<IteratorPlace, IteratorPlace> IteratorRange;		
+		//Passes the notifications of the list to the observer split by the strands and
+		//the chromosomes, and moves the subscribed iterators
+		template<class Observer>
+			class ListNotifier
+			{
+			public:
+				ListNotifier(DNASequence & sequence, Observer & observer): sequence_(sequence), observer_(observer) {}
+				void before(SequencePosIterator begin, SequencePosIterator end)
+				{
+					Notify<true>(begin, end);
+					sequence_.DetachSubscribers(begin, end);
+				}
+
+				void after(SequencePosIterator begin, SequencePosIterator end)
+				{
+					Notify<false>(begin, end);
+					sequence_.AttachSubscribers(begin);
+				}
+
+			private:
+				DNASequence & sequence_;
+				Observer & observer_;
+
+				template<bool isBefore>
+					void Notify(SequencePosIterator begin, SequencePosIterator end)
+					{
+						while(begin != end)
+						{
+							SequencePosIterator nowEnd = begin;
+							for(; nowEnd != end && nowEnd->actual != SEPARATION_CHAR; ++nowEnd);
+							StrandIterator pbegin(begin, positive);
+							StrandIterator pend(nowEnd, positive);
+							if(isBefore)
+							{
+								observer_.NotifyBefore(pbegin, pend);
+								observer_.NotifyBefore(pend.Invert(), pbegin.Invert());
+							}
+							else
+							{
+								observer_.NotifyAfter(pbegin, pend);
+								observer_.NotifyAfter(pend.Invert(), pbegin.Invert());
+							}
+
+							begin = nowEnd != end ? ++nowEnd : nowEnd;
+						}
+					}
+			};
+
+		//Iterators kept valid by the sequence are grouped by the chunk of the list they
+		//point to. The groups live in one array, an empty group is kept for reuse
+		typedef std::vector<SequencePosIterator*> SubscriberGroup;
 
 		void SubscribeIterator(SequencePosIterator & it);
 		void UnsubscribeIterator(SequencePosIterator & it);
-		void NotifyBefore(SequencePosIterator begin, SequencePosIterator end, NotifyFunction before);
-		void NotifyAfter(SequencePosIterator begin, SequencePosIterator end, NotifyFunction after);
-		SequencePosIterator ReplaceDirect(StrandIterator source,
-			size_t sourceDistance, 
-			SequencePosIterator target,
-			size_t targetDistance,
-			NotifyFunction before = 0,
-			NotifyFunction after = 0);
+		SubscriberGroup * FindSubscribers(const void * chunk);
+		void ReleaseSubscribers(const void * chunk);
+		void DetachSubscribers(SequencePosIterator begin, SequencePosIterator end);
+		void TagChunks(SequencePosIterator it, size_t count);
+		size_t SeparatorsBefore(SequencePosIterator it) const;
+		void AttachSubscribers(SequencePosIterator begin);
+		template<class Observer>
+			SequencePosIterator ReplaceDirect(StrandIterator source,
+				size_t sourceDistance, 
+				SequencePosIterator target,
+				size_t targetDistance,
+				Observer & observer);
 
 		Sequence sequence_;
 		std::vector<SequencePosIterator> posBegin_;
 		std::vector<SequencePosIterator> posEnd_;
-		IteratorMap iteratorStore_;
-		std::vector<IteratorPlace> toReplace_;
+		AddressMap<Size> subscriberGroup_;
+		std::vector<SubscriberGroup> subscriber_;
+		std::vector<Size> freeGroup_;
+		std::vector<std::pair<size_t, SequencePosIterator*> > moved_;
+		std::string insertBuffer_;
 	};	
+
+	template<class Observer>
+		DNASequence::SequencePosIterator DNASequence::ReplaceDirect(StrandIterator source,
+			size_t sourceDistance, 
+			SequencePosIterator target,
+			size_t targetDistance,
+			Observer & observer)
+		{	
+			StrandIterator save = StrandIterator(target, positive);
+			size_t firstPos = save.GetOriginalPosition();
+			size_t lastPos = AdvanceForward(save, targetDistance).GetOriginalPosition();
+			for(size_t i = 0; i < std::min(sourceDistance, targetDistance); i++)
+			{
+				*target = *source;
+				++target;
+				++source;
+			}
+
+			if(sourceDistance < targetDistance)
+			{
+				SequencePosIterator targetEnd = AdvanceForward(StrandIterator(target, positive), targetDistance - sourceDistance).Base();
+				target = sequence_.erase(target, targetEnd);			
+			}
+			else if(sourceDistance != targetDistance)
+			{			
+				ListNotifier<Observer> notifier(*this, observer);
+				StrandIterator sourceEnd = AdvanceForward(source, sourceDistance - targetDistance);
+				insertBuffer_.clear();
+				std::copy(source, sourceEnd, std::back_inserter(insertBuffer_));
+				target = sequence_.insert(target, insertBuffer_.begin(), insertBuffer_.end(), notifier);
+				TagChunks(target, insertBuffer_.size());
+				target = AdvanceForward(StrandIterator(target, positive), sourceDistance - targetDistance).Base();
+			}
+
+			double acc = static_cast<double>(firstPos);
+			double ssize = double(targetDistance) / sourceDistance;
+			for(size_t step = 0; step < sourceDistance; step++, ++save, acc += ssize)
+			{
+				size_t pos = std::min(lastPos, size_t(acc));
+				save.SetOriginalPosition(pos);
+			}
+
+			return target;
+		}
+
+	template<class Observer>
+		void DNASequence::Replace(StrandIterator source,
+			size_t sourceDistance, 
+			StrandIterator target,
+			size_t targetDistance,
+			Observer & observer)
+		{	
+			IncrementCounter(REPLACE_COUNTER);
+			if(target.GetDirection() == positive)
+			{
+				SequencePosIterator begin = target.Base();
+				begin = ReplaceDirect(source, sourceDistance, begin, targetDistance, observer);
+				target = AdvanceBackward(StrandIterator(begin, positive), sourceDistance);
+			}
+			else
+			{
+				source = AdvanceForward(source, sourceDistance).Invert();
+				SequencePosIterator begin = AdvanceForward(target, targetDistance).Invert().Base();
+				begin = ReplaceDirect(source, sourceDistance, begin, targetDistance, observer);
+				target = StrandIterator(--begin, negative);
+			}
+		}
 	
 	inline bool ProperKMer(DNASequence::StrandIterator it, size_t k)
 	{
@@ -11,33 +11,6 @@ namespace SyntenyFinder
 	BlockFinder::Edge::Edge(size_t chr, DNASequence::Direction direction, size_t startVertex, size_t endVertex, size_t actualPosition, size_t actualLength, size_t originalPosition, size_t originalLength, char firstChar):
 		chr(chr), direction(direction), startVertex(startVertex), endVertex(endVertex), actualPosition(actualPosition), actualLength(actualLength), originalPosition(originalPosition), originalLength(originalLength), firstChar(firstChar) {}
 
-	bool BlockFinder::CompareEdgesByDirection(const Edge & a, const Edge & b)
-	{
-		return a.GetDirection() < b.GetDirection();
-	}
-
-	bool BlockFinder::Edge::PositiveEdge(const Edge & edge)
-	{
-		return edge.direction == DNASequence::positive;
-	}
-
-	std::vector<size_t> BlockFinder::EdgeToVector(const Edge & a)
-	{
-		size_t feature[] = {a.GetStartVertex(), a.GetEndVertex(), static_cast<size_t>(a.GetFirstChar())};
-		return std::vector<size_t>(feature, feature + sizeof(feature) / sizeof(feature[0]));
-	}
-
-	bool BlockFinder::EdgeEmpty(const Edge & a, size_t k)
-	{
-		return a.GetOriginalLength() < k;
-	}
-
-	bool BlockFinder::CompareEdgesNaturally(const Edge & a, const Edge & b)
-	{
-		return EdgeToVector(a) < EdgeToVector(b);
-	}
-
-
 	size_t BlockFinder::Edge::GetChr() const
 	{
 		return chr;
@@ -87,4 +60,66 @@ namespace SyntenyFinder
 	{
 		return std::make_pair(GetChr(), GetActualPosition()) < std::make_pair(edge.GetChr(), edge.GetActualPosition());
 	}
+
+	void BlockFinder::EdgeTable::Clear()
+	{
+		chr_.clear();
+		startVertex_.clear();
+		endVertex_.clear();
+		actualPosition_.clear();
+		actualLength_.clear();
+		originalPosition_.clear();
+		originalLength_.clear();
+		direction_.clear();
+		firstChar_.clear();
+	}
+
+	size_t BlockFinder::EdgeTable::Size() const
+	{
+		return chr_.size();
+	}
+
+	void BlockFinder::EdgeTable::PushBack(size_t chr, DNASequence::Direction direction, size_t startVertex, size_t endVertex, size_t actualPosition, size_t actualLength, size_t originalPosition, size_t originalLength, char firstChar)
+	{
+		chr_.push_back(static_cast<SyntenyFinder::Size>(chr));
+		startVertex_.push_back(static_cast<SyntenyFinder::Size>(startVertex));
+		endVertex_.push_back(static_cast<SyntenyFinder::Size>(endVertex));
+		actualPosition_.push_back(static_cast<Pos>(actualPosition));
+		actualLength_.push_back(static_cast<Pos>(actualLength));
+		originalPosition_.push_back(static_cast<Pos>(originalPosition));
+		originalLength_.push_back(static_cast<Pos>(originalLength));
+		direction_.push_back(static_cast<char>(direction));
+		firstChar_.push_back(firstChar);
+	}
+
+	void BlockFinder::EdgeTable::Append(const EdgeTable & table)
+	{
+		chr_.insert(chr_.end(), table.chr_.begin(), table.chr_.end());
+		startVertex_.insert(startVertex_.end(), table.startVertex_.begin(), table.startVertex_.end());
+		endVertex_.insert(endVertex_.end(), table.endVertex_.begin(), table.endVertex_.end());
+		actualPosition_.insert(actualPosition_.end(), table.actualPosition_.begin(), table.actualPosition_.end());
+		actualLength_.insert(actualLength_.end(), table.actualLength_.begin(), table.actualLength_.end());
+		originalPosition_.insert(originalPosition_.end(), table.originalPosition_.begin(), table.originalPosition_.end());
+		originalLength_.insert(originalLength_.end(), table.originalLength_.begin(), table.originalLength_.end());
+		direction_.insert(direction_.end(), table.direction_.begin(), table.direction_.end());
+		firstChar_.insert(firstChar_.end(), table.firstChar_.begin(), table.firstChar_.end());
+	}
+
+	void BlockFinder::EdgeTable::Swap(EdgeTable & table)
+	{
+		chr_.swap(table.chr_);
+		startVertex_.swap(table.startVertex_);
+		endVertex_.swap(table.endVertex_);
+		actualPosition_.swap(table.actualPosition_);
+		actualLength_.swap(table.actualLength_);
+		originalPosition_.swap(table.originalPosition_);
+		originalLength_.swap(table.originalLength_);
+		direction_.swap(table.direction_);
+		firstChar_.swap(table.firstChar_);
+	}
+
+	BlockFinder::Edge BlockFinder::EdgeTable::operator [] (size_t idx) const
+	{
+		return Edge(chr_[idx], GetDirection(idx), startVertex_[idx], endVertex_[idx], actualPosition_[idx], actualLength_[idx], originalPosition_[idx], originalLength_[idx], firstChar_[idx]);
+	}
 }
\ No newline at end of file
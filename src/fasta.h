@@ -77,10 +77,11 @@ namespace SyntenyFinder
 			fileName_(fileName) {}
 		size_t 	GetSequences(std::vector<FASTARecord>& record);
 		bool 	IsOk() const;
+		//Converts the sequence to upper case, throws if it contains illegal characters
+		static void ValidateSequence(std::string & sequence);
 	private:
 		DISALLOW_COPY_AND_ASSIGN(FASTAReader);
 
-		void ValidateSequence(std::string & sequence);
 		void ValidateHeader(std::string & header);
 
 		std::ifstream inputStream_;
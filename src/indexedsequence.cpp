@@ -5,15 +5,22 @@
 //****************************************************************************
 
 #include "indexedsequence.h"
+#include "runstats.h"
 
 namespace SyntenyFinder
 {
-	IndexedSequence::IndexedSequence(const std::vector<std::string> & record, std::vector<std::vector<Pos> > & originalPos, size_t k, const std::string & tempDir, bool clear): k_(k)
+	namespace
 	{
-		Init(record, originalPos, k, tempDir, clear);
+		//K-mers up to this size fit into a 64-bit word
+		const size_t MAX_PACKED_K = 32;
 	}
 
-	IndexedSequence::IndexedSequence(const std::vector<std::string> & record, size_t k, const std::string & tempDir): k_(k)
+	IndexedSequence::IndexedSequence(const std::vector<std::string> & record, std::vector<std::vector<Pos> > & originalPos, size_t k, const std::string & tempDir, bool clear, Workspace * workspace, Enumeration enumeration): k_(k)
+	{
+		Init(record, originalPos, k, tempDir, clear, workspace, enumeration);
+	}
+
+	IndexedSequence::IndexedSequence(const std::vector<std::string> & record, size_t k, const std::string & tempDir, Workspace * workspace): k_(k)
 	{
 		std::vector<std::vector<Pos> > originalPos(record.size());
 		for(size_t i = 0; i < originalPos.size(); i++)
@@ -22,48 +29,75 @@ namespace SyntenyFinder
 			std::generate(originalPos[i].begin(), originalPos[i].end(), Counter<Pos>());
 		}
 
-		Init(record, originalPos, k, tempDir, false);
+		Init(record, originalPos, k, tempDir, false, workspace, suffixArray);
 	}
 
-	void IndexedSequence::Init(std::vector<std::string> record, std::vector<std::vector<Pos> > & originalPos, size_t k, const std::string & tempDir, bool clear)
+	void IndexedSequence::Init(std::vector<std::string> record, std::vector<std::vector<Pos> > & originalPos, size_t k, const std::string & tempDir, bool clear, Workspace * workspace, Enumeration enumeration)
 	{
 		size_t maxId;
+		//A local generator instead of rand(), so the result doesn't depend on other jobs running in the process
+		uint32_t seed = 1;
 		for(size_t i = 0; i < record.size(); i++)
 		{
 			for(size_t j = 0; j < record[i].size(); j++)
 			{
-				record[i][j] = IsDefiniteBase(record[i][j]) ? record[i][j] : DEFINITE_BASE[rand() % DEFINITE_BASE.size()];
+				if(!IsDefiniteBase(record[i][j]))
+				{
+					seed = seed * 1103515245 + 12345;
+					record[i][j] = DEFINITE_BASE[(seed >> 16) % DEFINITE_BASE.size()];
+				}
 			}
 		}
 
 		std::vector<std::vector<BifurcationInstance> > bifurcation(2);	
-		if(tempDir.size() == 0)
+		if(enumeration == bloomFilter)
 		{
-			maxId = EnumerateBifurcationsSArrayInRAM(record, bifurcation[0], bifurcation[1]);
+			maxId = EnumerateBifurcationsBloom(record, bifurcation[0], bifurcation[1]);
+		}
+		else if(enumeration == fmIndex)
+		{
+			maxId = EnumerateBifurcationsFM(record, bifurcation[0], bifurcation[1], workspace);
+		}
+		else if(tempDir.size() == 0 && k <= MAX_PACKED_K)
+		{
+			maxId = EnumerateBifurcationsPacked(record, bifurcation[0], bifurcation[1]);
+		}
+		else if(tempDir.size() == 0)
+		{
+			maxId = EnumerateBifurcationsSArrayInRAM(record, bifurcation[0], bifurcation[1], workspace);
 		}
 		else
 		{
-			maxId = EnumerateBifurcationsSArray(record, tempDir, bifurcation[0], bifurcation[1]);
+			maxId = EnumerateBifurcationsSArray(record, tempDir, bifurcation[0], bifurcation[1], workspace);
 		}
 
+		PhaseTimer timer("sequence_build");
 		bifStorage_.reset(new BifurcationStorage(maxId));
 		sequence_.reset(new DNASequence(record, originalPos, clear));
+		PhaseTimer loadTimer("bifurcation_storage");
+		std::vector<BifurcationStorage::BaseIterator> point;
 		for(size_t strand = 0; strand < 2; strand++)
 		{
 			size_t nowBif = 0;
+			point.clear();
+			point.reserve(bifurcation[strand].size());
 			DNASequence::Direction dir = static_cast<DNASequence::Direction>(strand);
 			for(size_t chr = 0; chr < sequence_->ChrNumber(); chr++)
 			{
 				size_t pos = 0;
 				StrandIterator end = sequence_->End(dir, chr);
-				for(DNASequence::StrandIterator it = sequence_->Begin(dir, chr); it != end; ++it, ++pos)
+				for(DNASequence::StrandIterator it = sequence_->Begin(dir, chr); it != end && nowBif < bifurcation[strand].size(); ++it, ++pos)
 				{
-					if(nowBif < bifurcation[strand].size() && chr == bifurcation[strand][nowBif].chr && pos == bifurcation[strand][nowBif].pos)
+					if(chr == bifurcation[strand][nowBif].chr && pos == bifurcation[strand][nowBif].pos)
 					{
-						bifStorage_->AddPoint(it, bifurcation[strand][nowBif++].bifId);
+						point.push_back(it.Base());
+						point.back().get_padding_int() = bifurcation[strand][nowBif++].bifId;
 					}
 				}
 			}
+
+			std::vector<BifurcationInstance>().swap(bifurcation[strand]);
+			bifStorage_->Load(dir, point);
 		}
 
 	#ifdef _DEBUG
@@ -122,26 +156,9 @@ namespace SyntenyFinder
 		return *bifStorage_;
 	}
 
-	void IndexedSequence::ConstructChrIndex()
-	{
-		chrIndex_.clear();
-		for(size_t chr = 0; chr < sequence_->ChrNumber(); chr++)
-		{
-			StrandIterator end = sequence_->PositiveEnd(chr);
-			for(StrandIterator begin = sequence_->PositiveBegin(chr); begin != end; ++begin)
-			{
-				chrIndex_.push_back(std::make_pair(begin, chr));
-			}
-		}
-
-		std::sort(chrIndex_.begin(), chrIndex_.end());
-	}
-	
 	size_t IndexedSequence::GetChr(StrandIterator it) const
 	{
-		IteratorChrPair look(it, 0);
-		std::vector<IteratorChrPair>::const_iterator jt = std::lower_bound(chrIndex_.begin(), chrIndex_.end(), look);
-		return jt->second;
+		return sequence_->GetChr(it);
 	}
 
 	bool IndexedSequence::StrandIteratorPosGEqual(StrandIterator a, StrandIterator b)
@@ -9,6 +9,7 @@
 
 #include "hashing.h"
 #include "platform.h"
+#include "workspace.h"
 #include "bifurcationstorage.h"
 
 namespace SyntenyFinder
@@ -18,25 +19,32 @@ namespace SyntenyFinder
 	class IndexedSequence
 	{
 	public:
+		//Suffix array needs ~20 bytes per base, Bloom filter needs ~2 bytes per base
+		//plus memory for the bifurcations, so it is preferable for large k. FM-index
+		//of the positive strand needs ~10 bytes per base for any k
+		enum Enumeration
+		{
+			suffixArray,
+			bloomFilter,
+			fmIndex
+		};
+
 		static const char SEPARATION_CHAR;
 		void Test();
 		DNASequence& Sequence();
 		const DNASequence& Sequence() const;
 		BifurcationStorage& BifStorage();
 		const BifurcationStorage& BifStorage() const;
-		void ConstructChrIndex();
 		size_t GetChr(StrandIterator it) const;
-		IndexedSequence(const std::vector<std::string> & record, size_t k, const std::string & tempDir);
-		IndexedSequence(const std::vector<std::string> & record, std::vector<std::vector<Pos> > & original, size_t k, const std::string & tempDir, bool clear = false);
+		IndexedSequence(const std::vector<std::string> & record, size_t k, const std::string & tempDir, Workspace * workspace = 0);
+		IndexedSequence(const std::vector<std::string> & record, std::vector<std::vector<Pos> > & original, size_t k, const std::string & tempDir, bool clear = false, Workspace * workspace = 0, Enumeration enumeration = suffixArray);
 		static bool StrandIteratorPosGEqual(StrandIterator a, StrandIterator b);		
 		static size_t StrandIteratorDistance(StrandIterator start, StrandIterator end);		
 	private:
 		DISALLOW_COPY_AND_ASSIGN(IndexedSequence);
-		typedef std::pair<StrandIterator, size_t> IteratorChrPair;
 		size_t k_;
 		std::auto_ptr<DNASequence> sequence_;
 		std::auto_ptr<BifurcationStorage> bifStorage_;
-		std::vector<IteratorChrPair> chrIndex_;		
 
 		struct IteratorHash
 		{
@@ -68,9 +76,14 @@ namespace SyntenyFinder
 		};
 
 		size_t GetMustBeBifurcation(StrandIterator it);
-		void Init(std::vector<std::string> record, std::vector<std::vector<Pos> > & original, size_t k, const std::string & tempDir, bool clear);
-		size_t EnumerateBifurcationsSArray(const std::vector<std::string> & data, const std::string & tempDir, std::vector<BifurcationInstance> & posBifurcation, std::vector<BifurcationInstance> & negBifurcation);
-		size_t EnumerateBifurcationsSArrayInRAM(const std::vector<std::string> & data, std::vector<BifurcationInstance> & posBifurcation, std::vector<BifurcationInstance> & negBifurcation);				
+		void Init(std::vector<std::string> record, std::vector<std::vector<Pos> > & original, size_t k, const std::string & tempDir, bool clear, Workspace * workspace, Enumeration enumeration);
+		size_t EnumerateBifurcationsSArray(const std::vector<std::string> & data, const std::string & tempDir, std::vector<BifurcationInstance> & posBifurcation, std::vector<BifurcationInstance> & negBifurcation, Workspace * workspace);
+		size_t EnumerateBifurcationsSArrayInRAM(const std::vector<std::string> & data, std::vector<BifurcationInstance> & posBifurcation, std::vector<BifurcationInstance> & negBifurcation, Workspace * workspace);				
+		size_t EnumerateBifurcationsFM(const std::vector<std::string> & data, std::vector<BifurcationInstance> & posBifurcation, std::vector<BifurcationInstance> & negBifurcation, Workspace * workspace);
+		size_t EnumerateBifurcationsBloom(const std::vector<std::string> & data, std::vector<BifurcationInstance> & posBifurcation, std::vector<BifurcationInstance> & negBifurcation);
+		size_t EnumerateBifurcationsPacked(const std::vector<std::string> & data, std::vector<BifurcationInstance> & posBifurcation, std::vector<BifurcationInstance> & negBifurcation);
+		template<class Word>
+			size_t EnumerateBifurcationsPackedWord(const std::vector<std::string> & data, std::vector<BifurcationInstance> & posBifurcation, std::vector<BifurcationInstance> & negBifurcation);
 	};
 }
 
@@ -0,0 +1,150 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#include "libsibelia.h"
+#include "pipeline.h"
+#include "blockindex.h"
+#include "util.h"
+
+namespace
+{
+	std::vector<std::pair<int, int> > PresetStages(const std::string & preset)
+	{
+		if(preset == "loose")
+		{
+			return LooseStageFile();
+		}
+
+		if(preset == "fine")
+		{
+			return FineStageFile();
+		}
+
+		if(preset == "far")
+		{
+			return FarStageFile();
+		}
+
+		throw std::runtime_error(("Unknown parameters set \"" + preset + "\"").c_str());
+	}
+
+	void CopyError(const std::string & message, char * error, size_t errorSize)
+	{
+		if(error != 0 && errorSize > 0)
+		{
+			size_t length = std::min(message.size(), errorSize - 1);
+			std::copy(message.begin(), message.begin() + length, error);
+			error[length] = 0;
+		}
+	}
+}
+
+extern "C" void sibelia_default_parameters(sibelia_parameters * parameters)
+{
+	SyntenyFinder::PipelineParameters defaults;
+	parameters->preset = "loose";
+	parameters->stage_k = 0;
+	parameters->stage_min_branch = 0;
+	parameters->stage_number = 0;
+	parameters->min_block_size = defaults.minBlockSize;
+	parameters->max_iterations = defaults.maxIterations;
+	parameters->max_multiplicity = defaults.maxMultiplicity;
+	parameters->shared_only = defaults.sharedOnly;
+	parameters->post_processing = defaults.postProcessing;
+	parameters->temp_dir = 0;
+	parameters->bloom_k = defaults.bloomK;
+	parameters->fm_index = defaults.fmIndex;
+}
+
+extern "C" int sibelia_find_blocks(const char * const * sequence,
+	const size_t * length,
+	size_t sequence_number,
+	const sibelia_parameters * parameters,
+	sibelia_block ** block,
+	size_t * block_number,
+	char * error,
+	size_t error_size)
+{
+	using namespace SyntenyFinder;
+	*block = 0;
+	*block_number = 0;
+	try
+	{
+		std::vector<FASTARecord> chrList;
+		for(size_t i = 0; i < sequence_number; i++)
+		{
+			if(length[i] == 0)
+			{
+				throw std::runtime_error("empty sequence");
+			}
+
+			std::stringstream description;
+			description << "seq" << i + 1;
+			std::string buffer(sequence[i], sequence[i] + length[i]);
+			FASTAReader::ValidateSequence(buffer);
+			chrList.push_back(FASTARecord(buffer, description.str(), i));
+		}
+
+		PipelineParameters pipeline;
+		if(parameters->stage_number > 0)
+		{
+			for(size_t i = 0; i < parameters->stage_number; i++)
+			{
+				pipeline.stage.push_back(std::make_pair(parameters->stage_k[i], parameters->stage_min_branch[i]));
+			}
+		}
+		else
+		{
+			pipeline.stage = PresetStages(parameters->preset != 0 ? parameters->preset : "loose");
+		}
+
+		pipeline.minBlockSize = parameters->min_block_size;
+		pipeline.maxIterations = parameters->max_iterations;
+		pipeline.maxMultiplicity = parameters->max_multiplicity;
+		pipeline.sharedOnly = parameters->shared_only != 0;
+		pipeline.postProcessing = parameters->post_processing != 0;
+		pipeline.tempDir = parameters->temp_dir != 0 ? parameters->temp_dir : "";
+		pipeline.bloomK = parameters->bloom_k;
+		pipeline.fmIndex = parameters->fm_index != 0;
+		std::vector<std::vector<BlockInstance> > history;
+		FindSyntenyBlocks(chrList, pipeline, history);
+
+		BlockIndex index(history.back(), chrList.size());
+		const std::vector<BlockInstance> & blockList = index.ById();
+		*block = static_cast<sibelia_block*>(malloc(sizeof(sibelia_block) * std::max(blockList.size(), size_t(1))));
+		if(*block == 0)
+		{
+			throw std::runtime_error("not enough memory");
+		}
+
+		for(size_t i = 0; i < blockList.size(); i++)
+		{
+			(*block)[i].signed_block_id = blockList[i].GetSignedBlockId();
+			(*block)[i].sequence = blockList[i].GetChrInstance().GetId();
+			(*block)[i].start = blockList[i].GetStart();
+			(*block)[i].end = blockList[i].GetEnd();
+		}
+
+		*block_number = blockList.size();
+	}
+	catch(std::exception & e)
+	{
+		CopyError(e.what(), error, error_size);
+		return 1;
+	}
+	catch(...)
+	{
+		CopyError("unknown error", error, error_size);
+		return 1;
+	}
+
+	return 0;
+}
+
+extern "C" void sibelia_free_blocks(sibelia_block * block)
+{
+	free(block);
+}
@@ -0,0 +1,76 @@
+/****************************************************************************
+ * Copyright (c) 2012 Saint-Petersburg Academic University
+ * All Rights Reserved
+ * See file LICENSE for details.
+ ****************************************************************************/
+
+#ifndef _LIBSIBELIA_H_
+#define _LIBSIBELIA_H_
+
+#include <stddef.h>
+
+/* C interface of the Sibelia library. Sequences are passed as memory buffers and
+ * the blocks are returned in an array, no files are read or written unless a
+ * directory for temporary files is given. All the functions are reentrant, so
+ * many comparisons can run concurrently in one process. */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+	/* Negative if the instance is located on the reverse strand */
+	int signed_block_id;
+	/* Zero-based number of the input sequence */
+	size_t sequence;
+	/* Zero-based coordinates of the instance, end is exclusive */
+	size_t start;
+	size_t end;
+} sibelia_block;
+
+typedef struct
+{
+	/* Name of the parameters set ("loose", "fine" or "far"), used if stage_number == 0 */
+	const char * preset;
+	/* Pairs (stage_k[i], stage_min_branch[i]) of the simplification stages */
+	const int * stage_k;
+	const int * stage_min_branch;
+	size_t stage_number;
+	size_t min_block_size;
+	size_t max_iterations;
+	/* Bifurcations with more occurrences are not simplified, 0 means no limit */
+	size_t max_multiplicity;
+	int shared_only;
+	int post_processing;
+	/* Directory for temporary files, NULL means that all computations are in RAM */
+	const char * temp_dir;
+	/* Stages with k >= bloom_k find vertices with a Bloom filter, 0 means never */
+	size_t bloom_k;
+	/* Nonzero means that vertices are found with an FM-index of the positive strand */
+	int fm_index;
+} sibelia_parameters;
+
+/* Fills the parameters with the defaults of the Sibelia program */
+void sibelia_default_parameters(sibelia_parameters * parameters);
+
+/* Finds synteny blocks in sequence[0], ..., sequence[sequence_number - 1], the
+ * sequences are not required to be null-terminated. On success returns 0 and
+ * stores the blocks sorted by id into *block, which must be released with
+ * sibelia_free_blocks. On failure returns a nonzero value and copies the
+ * description of the error into the buffer "error" of size error_size. */
+int sibelia_find_blocks(const char * const * sequence,
+	const size_t * length,
+	size_t sequence_number,
+	const sibelia_parameters * parameters,
+	sibelia_block ** block,
+	size_t * block_number,
+	char * error,
+	size_t error_size);
+
+void sibelia_free_blocks(sibelia_block * block);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
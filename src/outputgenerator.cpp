@@ -7,13 +7,14 @@
 #pragma GCC diagnostic ignored "-Wc++11-extensions"
 
 #include "outputgenerator.h"
+#include "blockcoords.h"
 #include "platform.h"
+#include "parallel.h"
 
 namespace SyntenyFinder
 {
 	namespace
 	{
-		const char COVERED = 1;
 		typedef std::pair<size_t, std::vector<BlockInstance> > GroupedBlock;
 		typedef std::vector<GroupedBlock> GroupedBlockList;		
 
@@ -51,15 +52,13 @@ namespace SyntenyFinder
 			return out.str();
 		}
 
-		void OutputBlocks(const std::vector<BlockInstance>& block, std::ofstream& out)
+		void OutputBlocks(const BlockIndex & index, std::ofstream& out)
 		{
-			std::vector<IndexPair> group;
-			std::vector<BlockInstance> blockList = block;
-			GroupBy(blockList, compareById, std::back_inserter(group));
-			for(std::vector<IndexPair>::iterator it = group.begin(); it != group.end(); ++it)
+			const std::vector<BlockInstance> & blockList = index.ById();
+			const std::vector<IndexPair> & group = index.IdGroup();
+			for(std::vector<IndexPair>::const_iterator it = group.begin(); it != group.end(); ++it)
 			{
 				size_t length = it->second - it->first;
-				std::sort(blockList.begin() + it->first, blockList.begin() + it->second, compareByChrId);
 				out << "Block #" << blockList[it->first].GetBlockId() << std::endl;
 				out << "Seq_id\tStrand\tStart\tEnd\tLength" << std::endl;
 				CopyN(CFancyIterator(blockList.begin() + it->first, OutputIndex, std::string()),
@@ -86,7 +85,7 @@ namespace SyntenyFinder
 			return out.str();
 		}
 
-		void OutputLink(std::vector<BlockInstance>::iterator block, int color, int fillLength,
+		void OutputLink(std::vector<BlockInstance>::const_iterator block, int color, int fillLength,
 						int linkId, std::ostream& stream)
 		{
 			size_t start = block->GetConventionalStart();
@@ -99,42 +98,106 @@ namespace SyntenyFinder
 			stream << " color=chr" << color << "_a2" << std::endl;
 		}
 
-		template<class Iterator>
-			void OutputLines(Iterator start, size_t length, std::ostream & out)
+		bool CompareRecordsNaturally(const std::vector<BlockInstance> * block, size_t a, size_t b)
+		{
+			return CompareBlocksNaturally((*block)[a], (*block)[b]);
+		}
+
+		const size_t FASTA_LINE_LENGTH = 80;
+		const size_t FASTA_SHARD_SIZE = 1 << 22;
+
+		void AppendLines(const char * seq, size_t length, std::string & buffer)
+		{
+			for(size_t pos = 0; pos < length; pos += FASTA_LINE_LENGTH)
+			{
+				buffer.append(seq + pos, std::min(FASTA_LINE_LENGTH, length - pos));
+				buffer.push_back('\n');
+			}
+		}
+
+		void FormatBlockSequence(const BlockInstance & block, const char * complement, std::string & revComp, std::string & buffer)
+		{
+			size_t length = block.GetLength();
+			char strand = block.GetSignedBlockId() > 0 ? '+' : '-';
+			const FASTARecord & chr = block.GetChrInstance();
+			std::stringstream header;
+			header << ">Seq=\"" << chr.GetDescription() << "\",Strand='" << strand << "',";
+			header << "Block_id=" << block.GetBlockId() << ",Start=" ;
+			header << block.GetConventionalStart() << ",End=" << block.GetConventionalEnd() << std::endl;
+			buffer.append(header.str());
+			const char * seq = chr.GetSequence().data() + block.GetStart();
+			if(block.GetSignedBlockId() < 0)
 			{
-				for(size_t i = 1; i <= length; i++, ++start)
+				revComp.resize(length);
+				for(size_t i = 0; i < length; i++)
 				{
-					out << *start;
-					if(i % 80 == 0 && i != length)
-					{
-						out << std::endl;
-					}
+					revComp[length - i - 1] = complement[static_cast<unsigned char>(seq[i])];
 				}
+
+				seq = revComp.data();
 			}
 
+			AppendLines(seq, length, buffer);
+			if(length == 0)
+			{
+				buffer.push_back('\n');
+			}
+		}
+
+		struct Interval
+		{
+			size_t chr;
+			size_t start;
+			size_t end;
+			Interval() {}
+			Interval(size_t chr, size_t start, size_t end): chr(chr), start(start), end(end) {}
+			bool operator < (const Interval & other) const
+			{
+				return std::make_pair(chr, start) < std::make_pair(other.chr, other.start);
+			}
+		};
+
+		//Sorts the instances by chromosome and start once and merges the overlapping
+		//ones, so it takes O(B log B) time and doesn't depend on the size of the genome
 		std::vector<double> CalculateCoverage(const ChrList & chrList, GroupedBlockList::const_iterator start, GroupedBlockList::const_iterator end)
 		{
-			std::vector<double> ret;
-			std::vector<char> cover;
-			double totalBp = 0;
-			double totalCoveredBp = 0;
-			for(size_t chr = 0; chr < chrList.size(); chr++)
+			std::vector<Interval> interval;
+			for(GroupedBlockList::const_iterator it = start; it != end; ++it)
 			{
-				totalBp += chrList[chr].GetSequence().size();
-				cover.assign(chrList[chr].GetSequence().size(), 0);
-				for(GroupedBlockList::const_iterator it = start; it != end; ++it)
+				for(size_t i = 0; i < it->second.size(); i++)
 				{
-					for(size_t i = 0; i < it->second.size(); i++)
+					const BlockInstance & block = it->second[i];
+					if(block.GetStart() < block.GetEnd())
 					{
-						if(it->second[i].GetChrInstance().GetId() == chr)
-						{
-							std::fill(cover.begin() + it->second[i].GetStart(), cover.begin() + it->second[i].GetEnd(), COVERED);
-						}
+						interval.push_back(Interval(block.GetChrInstance().GetId(), block.GetStart(), block.GetEnd()));
 					}
 				}
+			}
+
+			std::sort(interval.begin(), interval.end());
+			std::vector<size_t> coveredBp(chrList.size(), 0);
+			for(size_t i = 0; i < interval.size(); )
+			{
+				size_t chr = interval[i].chr;
+				size_t runStart = interval[i].start;
+				size_t runEnd = interval[i].end;
+				for(++i; i < interval.size() && interval[i].chr == chr && interval[i].start <= runEnd; ++i)
+				{
+					runEnd = std::max(runEnd, interval[i].end);
+				}
 
-				double nowCoveredBp = static_cast<double>(std::count(cover.begin(), cover.end(), COVERED));
-				ret.push_back(nowCoveredBp / cover.size() * 100);
+				coveredBp[chr] += runEnd - runStart;
+			}
+
+			std::vector<double> ret;
+			double totalBp = 0;
+			double totalCoveredBp = 0;
+			for(size_t chr = 0; chr < chrList.size(); chr++)
+			{
+				double size = static_cast<double>(chrList[chr].GetSequence().size());
+				double nowCoveredBp = static_cast<double>(coveredBp[chr]);
+				totalBp += size;
+				ret.push_back(nowCoveredBp / size * 100);
 				totalCoveredBp += nowCoveredBp;
 			}
 
@@ -159,15 +222,14 @@ namespace SyntenyFinder
 		out << DELIMITER << std::endl;
 	}	
 
-	void OutputGenerator::GenerateReport(const BlockList & block, const std::string & fileName) const
+	void OutputGenerator::GenerateReport(const BlockIndex & index, const std::string & fileName) const
 	{
 		std::ofstream out;
 		TryOpenFile(fileName, out);
 		GroupedBlockList sepBlock;
-		std::vector<IndexPair> group;
-		BlockList blockList = block;
-		GroupBy(blockList, compareById, std::back_inserter(group));
-		for(std::vector<IndexPair>::iterator it = group.begin(); it != group.end(); ++it)
+		const BlockList & blockList = index.ById();
+		const std::vector<IndexPair> & idGroup = index.IdGroup();
+		for(std::vector<IndexPair>::const_iterator it = idGroup.begin(); it != idGroup.end(); ++it)
 		{
 			sepBlock.push_back(std::make_pair(it->second - it->first, std::vector<BlockInstance>(blockList.begin() + it->first, blockList.begin() + it->second)));
 		}
@@ -180,7 +242,7 @@ namespace SyntenyFinder
 		}
 
 		out << std::endl;
-		group.clear();
+		std::vector<IndexPair> group;
 		GroupBy(sepBlock, ByFirstElement, std::back_inserter(group));
 		group.push_back(IndexPair(0, sepBlock.size()));
 		for(std::vector<IndexPair>::iterator it = group.begin(); it != group.end(); ++it)
@@ -204,20 +266,18 @@ namespace SyntenyFinder
 		out << DELIMITER << std::endl;
 	}
 
-	void OutputGenerator::ListChromosomesAsPermutations(const BlockList & block, const std::string & fileName) const
+	void OutputGenerator::ListChromosomesAsPermutations(const BlockIndex & index, const std::string & fileName) const
 	{
 		std::ofstream out;
 		TryOpenFile(fileName, out);
-		std::vector<IndexPair> group;
-		BlockList blockList = block;
-		GroupBy(blockList, compareByChrId, std::back_inserter(group));
- 		for(std::vector<IndexPair>::iterator it = group.begin(); it != group.end(); ++it)
+		const BlockList & blockList = index.ByChr();
+		const std::vector<IndexPair> & group = index.ChrGroup();
+ 		for(std::vector<IndexPair>::const_iterator it = group.begin(); it != group.end(); ++it)
 		{
 			out.setf(std::ios_base::showpos);
 			size_t length = it->second - it->first;
 			size_t chr = blockList[it->first].GetChrInstance().GetId();
 			out << '>' << chrList_[chr].GetDescription() << std::endl;
-			std::sort(blockList.begin() + it->first, blockList.begin() + it->second);
 			CopyN(CFancyIterator(blockList.begin() + it->first, boost::bind(&BlockInstance::GetSignedBlockId, _1), 0), length, std::ostream_iterator<int>(out, " "));
 			out << "$" << std::endl;
 		}
@@ -233,12 +293,12 @@ namespace SyntenyFinder
 		}
 	}
 
-	void OutputGenerator::ListBlocksIndices(const BlockList & block, const std::string & fileName) const
+	void OutputGenerator::ListBlocksIndices(const BlockIndex & index, const std::string & fileName) const
 	{
 		std::ofstream out;
 		TryOpenFile(fileName, out);
 		ListChrs(out);
-		OutputBlocks(block, out);
+		OutputBlocks(index, out);
 	}
 
 	
@@ -280,39 +340,55 @@ namespace SyntenyFinder
 		for (size_t i = 0; i < history.size(); ++i)
 		{
 			out << "\n================== ITERATION " << i + 1 << "===================\nBlk\tChr\tChld\n";
-			OutputBlocks(history[i], out);
+			OutputBlocks(BlockIndex(history[i], chrList_.size()), out);
 		}
 	}
 
-	void OutputGenerator::ListBlocksSequences(const BlockList & block, const std::string & fileName) const
+	void OutputGenerator::ListBlocksSequences(const BlockIndex & index, const std::string & fileName) const
 	{
 		std::ofstream out;
 		TryOpenFile(fileName, out);
-		std::vector<IndexPair> group;
-		BlockList blockList = block;
-		GroupBy(blockList, compareById, std::back_inserter(group));
-		for(std::vector<IndexPair>::iterator it = group.begin(); it != group.end(); ++it)
+		char complement[1 << (sizeof(char) * 8)];
+		for(size_t i = 0; i < sizeof(complement); i++)
 		{
-			for(size_t block = it->first; block < it->second; block++)
+			complement[i] = i < 128 ? DNASequence::Translate(static_cast<char>(i)) : static_cast<char>(i);
+		}
+
+		//Split the instances into shards of roughly equal total length
+		const BlockList & blockList = index.ById();
+		std::vector<size_t> shardStart(1, 0);
+		for(size_t i = 0, length = 0; i < blockList.size(); i++)
+		{
+			length += blockList[i].GetLength();
+			if(length >= FASTA_SHARD_SIZE || i + 1 == blockList.size())
 			{
-				size_t length = blockList[block].GetLength();
-				char strand = blockList[block].GetSignedBlockId() > 0 ? '+' : '-';
-				const FASTARecord & chr = blockList[block].GetChrInstance();
-				out << ">Seq=\"" << chr.GetDescription() << "\",Strand='" << strand << "',";
-				out << "Block_id=" << blockList[block].GetBlockId() << ",Start=" ;
-				out << blockList[block].GetConventionalStart() << ",End=" << blockList[block].GetConventionalEnd() << std::endl;
-
-				if(blockList[block].GetSignedBlockId() > 0)
-				{
-					OutputLines(chr.GetSequence().begin() + blockList[block].GetStart(), length, out);
-				}
-				else
+				shardStart.push_back(i + 1);
+				length = 0;
+			}
+		}
+
+		//Format a round of shards in parallel, then write them in order
+		int shards = static_cast<int>(shardStart.size()) - 1;
+		int round = static_cast<int>(GetThreadsNumber());
+		std::vector<std::string> buffer(round);
+		for(int first = 0; first < shards; first += round)
+		{
+			int last = std::min(first + round, shards);
+			#pragma omp parallel for schedule(dynamic, 1)
+			for(int shard = first; shard < last; shard++)
+			{
+				std::string revComp;
+				std::string & now = buffer[shard - first];
+				now.clear();
+				for(size_t i = shardStart[shard]; i < shardStart[shard + 1]; i++)
 				{
-					std::string::const_reverse_iterator it(chr.GetSequence().begin() + blockList[block].GetEnd());
-					OutputLines(CFancyIterator(it, DNASequence::Translate, ' '), length, out);
+					FormatBlockSequence(blockList[i], complement, revComp, now);
 				}
+			}
 
-				out << std::endl;
+			for(int shard = first; shard < last; shard++)
+			{
+				out.write(buffer[shard - first].data(), buffer[shard - first].size());
 			}
 		}
 	}
@@ -331,15 +407,26 @@ namespace SyntenyFinder
 		std::ofstream config;
 		CreateOutDirectory(outDir);
 		TryOpenFile(outFile, config);
-		config << circosTemplate;		
-		WriteCircosLinks(outDir, "circos.segdup.txt", history.back());
-		WriteCircosKaryoType(outDir, "circos.sequences.txt", history);
+		config << circosTemplate;
+		std::set<size_t> chrToShow;
+		std::vector<BlockList> sortedHistory(history.size());
+		for(size_t i = 0; i < history.size(); i++)
+		{
+			sortedHistory[i] = BlockIndex(history[i], chrList_.size()).ById();
+			for(BlockList::const_iterator it = history[i].begin(); it != history[i].end(); ++it)
+			{
+				chrToShow.insert(it->GetChrId());
+			}
+		}
+
+		WriteCircosLinks(outDir, "circos.segdup.txt", sortedHistory.back());
+		WriteCircosKaryoType(outDir, "circos.sequences.txt", chrToShow);
 		config << "<highlights>\n\tfill_color = green" << std::endl;		
-		WriteCircosHighlight(outDir, "circos.highlight.txt", history.back(), 0, 0, true, config);		
-		for(std::vector<BlockList>::const_reverse_iterator it = ++history.rbegin(); it != history.rend(); ++it)
+		WriteCircosHighlight(outDir, "circos.highlight.txt", sortedHistory.back(), 0, 0, true, config);		
+		for(std::vector<BlockList>::const_reverse_iterator it = ++sortedHistory.rbegin(); it != sortedHistory.rend(); ++it)
 		{			
 			std::stringstream ss;
-			ss << "circos.highlight" << it - history.rbegin() << ".txt";
+			ss << "circos.highlight" << it - sortedHistory.rbegin() << ".txt";
 			WriteCircosHighlight(outDir, ss.str(), *it, r, r + CIRCOS_HIGHLIGHT_THICKNESS, false, config);			
 			r += static_cast<int>(CIRCOS_HIGHLIGHT_THICKNESS * 1.5);
 		}
@@ -351,27 +438,31 @@ namespace SyntenyFinder
 		WriteCircosImageConfig(outDir, "circos.image.conf", CIRCOS_DEFAULT_RADIUS + CIRCOS_RESERVED_FOR_LABEL + r);
 	}
 
-	void OutputGenerator::GenerateCircosOutput(const BlockList & blockList, const std::string & outFile, const std::string & outDir) const
+	void OutputGenerator::GenerateCircosOutput(const BlockIndex & index, const std::string & outFile, const std::string & outDir) const
 	{		
 		std::ofstream config;
 		CreateOutDirectory(outDir);
 		TryOpenFile(outFile, config);
-		config << circosTemplate;		
-		WriteCircosLinks(outDir, "circos.segdup.txt", blockList);		
-		WriteCircosKaryoType(outDir, "circos.sequences.txt", std::vector<BlockList>(1, blockList));
+		config << circosTemplate;
+		std::set<size_t> chrToShow;
+		const std::vector<IndexPair> & chrGroup = index.ChrGroup();
+		for(std::vector<IndexPair>::const_iterator it = chrGroup.begin(); it != chrGroup.end(); ++it)
+		{
+			chrToShow.insert(index.ByChr()[it->first].GetChrId());
+		}
+
+		WriteCircosLinks(outDir, "circos.segdup.txt", index.ById());		
+		WriteCircosKaryoType(outDir, "circos.sequences.txt", chrToShow);
 		config << "<highlights>\n\tfill_color = green" << std::endl;		
-		WriteCircosHighlight(outDir, "circos.highlight.txt", blockList, 0, 0, true, config);
+		WriteCircosHighlight(outDir, "circos.highlight.txt", index.ById(), 0, 0, true, config);
 		config << "</highlights>" << std::endl;
 		config << "<ideogram>\n\tlabel_radius = 1.08r\n</ideogram>" << std::endl;
 		WriteCircosImageConfig(outDir, "circos.image.conf", CIRCOS_DEFAULT_RADIUS);
 	}
 
-	void OutputGenerator::WriteCircosLinks(const std::string & outDir, const std::string & fileName, const BlockList & block) const
+	void OutputGenerator::WriteCircosLinks(const std::string & outDir, const std::string & fileName, const BlockList & sortedBlocks) const
 	{
 		//blocks must be sorted by id
-		BlockList sortedBlocks = block;
-		std::sort(sortedBlocks.begin(), sortedBlocks.end(), compareById);
-
 		//write link and highlights file
 		int idLength = static_cast<int>(log10(static_cast<double>(sortedBlocks.size()))) + 1;
 		int lastId = 0;
@@ -381,7 +472,7 @@ namespace SyntenyFinder
 		TryOpenFile(outDir + "/" + fileName, linksFile);
 
 		int color = 0;
-		for(BlockList::iterator itBlock = sortedBlocks.begin(); itBlock != sortedBlocks.end(); ++itBlock)
+		for(BlockList::const_iterator itBlock = sortedBlocks.begin(); itBlock != sortedBlocks.end(); ++itBlock)
 		{
 			if (itBlock->GetBlockId() != lastId)
 			{
@@ -389,7 +480,7 @@ namespace SyntenyFinder
 				lastId = itBlock->GetBlockId();
 			}
 
-			for (BlockList::iterator itPair = blocksToLink.begin(); itPair != blocksToLink.end(); ++itPair)
+			for (BlockList::const_iterator itPair = blocksToLink.begin(); itPair != blocksToLink.end(); ++itPair)
 			{
 				color = (color + 1) % CIRCOS_MAX_COLOR;
 				//link start
@@ -403,15 +494,13 @@ namespace SyntenyFinder
 		}
 	}
 
-	void OutputGenerator::WriteCircosHighlight(const std::string & outDir, const std::string & fileName, const BlockList & block, int r0, int r1, bool ideogram, std::ofstream & config) const
+	void OutputGenerator::WriteCircosHighlight(const std::string & outDir, const std::string & fileName, const BlockList & sortedBlocks, int r0, int r1, bool ideogram, std::ofstream & config) const
 	{
+		//blocks must be sorted by id
 		int color = 0;
-		BlockList sortedBlocks = block;
-		std::sort(sortedBlocks.begin(), sortedBlocks.end(), compareById);
-		BlockList blocksToLink;		
 		std::ofstream highlightFile;		
 		TryOpenFile(outDir + "/" + fileName, highlightFile);
-		for(BlockList::iterator itBlock = sortedBlocks.begin(); itBlock != sortedBlocks.end(); ++itBlock)
+		for(BlockList::const_iterator itBlock = sortedBlocks.begin(); itBlock != sortedBlocks.end(); ++itBlock)
 		{
 			highlightFile << "seq" << itBlock->GetChrInstance().GetConventionalId() << " ";
 			size_t blockStart = itBlock->GetConventionalStart();
@@ -455,19 +544,10 @@ namespace SyntenyFinder
 		config << "\t</highlight>" << std::endl;
 	}
 
-	void OutputGenerator::WriteCircosKaryoType(const std::string & outDir, const std::string & fileName, const std::vector<BlockList> & history) const
+	void OutputGenerator::WriteCircosKaryoType(const std::string & outDir, const std::string & fileName, const std::set<size_t> & chrToShow) const
 	{
 		std::ofstream karFile;		
 		TryOpenFile(outDir + "/" + fileName, karFile);
-		std::set<size_t> chrToShow;
-		for(std::vector<BlockList>::const_iterator jt = history.begin(); jt != history.end(); ++jt)
-		{
-			for(BlockList::const_iterator it = jt->begin(); it != jt->end(); ++it)
-			{
-				chrToShow.insert(it->GetChrId());
-			}
-		}
-
 		for (size_t i = 0; i < chrList_.size(); ++i)
 		{
 			if(chrToShow.count(chrList_[i].GetId()))
@@ -480,7 +560,7 @@ namespace SyntenyFinder
 		}
 	}
 
-	void OutputGenerator::GenerateD3Output(const BlockList & blockList, const std::string & outFile) const
+	void OutputGenerator::GenerateD3Output(const BlockIndex & index, const std::string & outFile) const
 	{
 		std::istringstream htmlTemplate(d3Template);
 
@@ -505,32 +585,38 @@ namespace SyntenyFinder
 		out << "chart_data = [" << std::endl;
 
 		//blocks must be sorted by start
-		BlockList sortedBlocks = blockList;
-		std::sort(sortedBlocks.begin(), sortedBlocks.end(), compareByStart);
+		const BlockList & sortedBlocks = index.ByStart();
+		std::vector<std::string> label(sortedBlocks.size());
+		boost::unordered_map<int, std::vector<size_t> > instance;
+		for(size_t i = 0; i < sortedBlocks.size(); i++)
+		{
+			label[i] = OutputD3BlockID(sortedBlocks[i]);
+			instance[sortedBlocks[i].GetBlockId()].push_back(i);
+		}
 
 		// write to output file
-		int lastId = 0;
 		bool first_line = true;
-		for(BlockList::iterator itBlock = sortedBlocks.begin(); itBlock != sortedBlocks.end(); ++itBlock) // O(N^2) by number of blocks, can be optimized
+		for(size_t i = 0; i < sortedBlocks.size(); i++)
 		{
 			if (!first_line)
 				out << ",";
 			else
 				first_line = false;
 			out << "    {";
-			out << "\"name\":\"" << OutputD3BlockID(*itBlock) << "\",";
-			out << "\"size\":" << itBlock->GetLength() << ",";
+			out << "\"name\":\"" << label[i] << "\",";
+			out << "\"size\":" << sortedBlocks[i].GetLength() << ",";
 			out << "\"imports\":[";
 			bool first = true;
-			for (BlockList::iterator itPair = sortedBlocks.begin(); itPair != sortedBlocks.end(); ++itPair)
+			const std::vector<size_t> & pair = instance[sortedBlocks[i].GetBlockId()];
+			for (std::vector<size_t>::const_iterator itPair = pair.begin(); itPair != pair.end(); ++itPair)
 			{
-				if (itPair->GetBlockId() == itBlock->GetBlockId() && itPair != itBlock)
+				if (*itPair != i)
 				{
 					if (!first)
 						out << ",";
 					else
 						first = false;
-					out << "\"" << OutputD3BlockID(*itPair) << "\"";
+					out << "\"" << label[*itPair] << "\"";
 				}
 			}
 			out << "]";
@@ -595,12 +681,11 @@ namespace SyntenyFinder
 		std::copy(block, block + blockSize, std::ostream_iterator<std::string>(ss, "\n"));
 	}
 
-	void OutputGenerator::ListBlocksIndicesGFF(const BlockList & blockList, const std::string & fileName) const
+	void OutputGenerator::ListBlocksIndicesGFF(const BlockIndex & index, const std::string & fileName) const
 	{
 		std::ofstream out;
 		TryOpenFile(fileName, out);
-		BlockList block(blockList);
-		std::sort(block.begin(), block.end(), compareById);
+		const BlockList & block = index.ById();
 		const std::string header[] =
 		{
 			"##gff-version 2",
@@ -630,7 +715,76 @@ namespace SyntenyFinder
 		}
 	}
 
-    void OutputGenerator::OutputBlocksInSAM(const BlockList & block, const std::string & fileName) const
+	void OutputGenerator::ListBlocksIndicesBinary(const BlockIndex & index, const std::string & fileName) const
+	{
+		using namespace BlockCoords;
+		std::ofstream out(fileName.c_str(), std::ios::out | std::ios::binary);
+		if(!out)
+		{
+			throw std::runtime_error(("Cannot open file " + fileName).c_str());
+		}
+
+		const BlockList & block = index.ById();
+		size_t maxBlockId = block.empty() ? 0 : block.back().GetBlockId();
+		std::vector<size_t> chrOrder(block.size());
+		for(size_t i = 0; i < block.size(); i++)
+		{
+			chrOrder[i] = i;
+		}
+
+		std::stable_sort(chrOrder.begin(), chrOrder.end(), boost::bind(CompareRecordsNaturally, &block, _1, _2));
+		uint64_t recordOffset = HEADER_SIZE;
+		uint64_t blockIndexOffset = recordOffset + block.size() * RECORD_SIZE;
+		uint64_t chrOrderOffset = blockIndexOffset + (maxBlockId + 2) * 4;
+		uint64_t chrIndexOffset = chrOrderOffset + block.size() * 4;
+		uint64_t chrTableOffset = chrIndexOffset + (chrList_.size() + 1) * 4;
+
+		std::string buffer(MAGIC, MAGIC + MAGIC_SIZE);
+		PutUInt32(buffer, VERSION);
+		PutUInt32(buffer, static_cast<uint32_t>(chrList_.size()));
+		PutUInt32(buffer, static_cast<uint32_t>(block.size()));
+		PutUInt32(buffer, static_cast<uint32_t>(maxBlockId));
+		PutUInt64(buffer, recordOffset);
+		PutUInt64(buffer, blockIndexOffset);
+		PutUInt64(buffer, chrOrderOffset);
+		PutUInt64(buffer, chrIndexOffset);
+		PutUInt64(buffer, chrTableOffset);
+		for(BlockList::const_iterator it = block.begin(); it != block.end(); ++it)
+		{
+			PutUInt32(buffer, static_cast<uint32_t>(it->GetSignedBlockId()));
+			PutUInt32(buffer, static_cast<uint32_t>(it->GetChrId()));
+			PutUInt32(buffer, static_cast<uint32_t>(it->GetConventionalStart()));
+			PutUInt32(buffer, static_cast<uint32_t>(it->GetConventionalEnd()));
+		}
+
+		for(size_t id = 0, now = 0; id <= maxBlockId + 1; id++)
+		{
+			for(; now < block.size() && static_cast<size_t>(block[now].GetBlockId()) < id; now++);
+			PutUInt32(buffer, static_cast<uint32_t>(now));
+		}
+
+		for(size_t i = 0; i < chrOrder.size(); i++)
+		{
+			PutUInt32(buffer, static_cast<uint32_t>(chrOrder[i]));
+		}
+
+		for(size_t chr = 0, now = 0; chr <= chrList_.size(); chr++)
+		{
+			for(; now < chrOrder.size() && block[chrOrder[now]].GetChrId() < chr; now++);
+			PutUInt32(buffer, static_cast<uint32_t>(now));
+		}
+
+		for(size_t chr = 0; chr < chrList_.size(); chr++)
+		{
+			PutUInt64(buffer, chrList_[chr].GetSequence().size());
+			PutUInt32(buffer, static_cast<uint32_t>(chrList_[chr].GetDescription().size()));
+			buffer.append(chrList_[chr].GetDescription());
+		}
+
+		out.write(buffer.data(), buffer.size());
+	}
+
+    void OutputGenerator::OutputBlocksInSAM(const BlockIndex & index, const std::string & fileName) const
     {
         std::ofstream out;
         TryOpenFile(fileName, out);
@@ -649,12 +803,10 @@ namespace SyntenyFinder
             out << SQTag << '\n';
         }
 
-        BlockList blockList = block;
-        std::vector<IndexPair> group;
-        GroupBy(blockList, compareById, std::back_inserter(group));
-        for(std::vector<IndexPair>::iterator it = group.begin(); it != group.end(); ++it)
+        const BlockList & blockList = index.ById();
+        const std::vector<IndexPair> & group = index.IdGroup();
+        for(std::vector<IndexPair>::const_iterator it = group.begin(); it != group.end(); ++it)
         {
-            std::sort(blockList.begin() + it->first, blockList.begin() + it->second, compareByChrId);
             std::stringstream ss;
             ss << blockList[it->first].GetBlockId();
             std::string s = ss.str();
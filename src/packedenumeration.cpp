@@ -0,0 +1,245 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#include "indexedsequence.h"
+#include "runstats.h"
+#include "parallel.h"
+
+namespace SyntenyFinder
+{
+	namespace
+	{
+		const size_t DIGIT_BITS = 8;
+		const size_t RADIX = size_t(1) << DIGIT_BITS;
+		const size_t MIN_CHUNK_SIZE = 1 << 16;
+		//Code of the separation char, the bases are coded by 0..3
+		const size_t END_CODE = 4;
+		//Layout of the tag of an occurrence: codes of the previous and the next
+		//chars and whether the k-mer in the key is the reverse complement
+		const size_t PREV_SHIFT = 3;
+		const size_t NEXT_MASK = 7;
+		const char FLIPPED = 1 << 6;
+
+		size_t BaseCode(char ch)
+		{
+			switch(ch)
+			{
+			case 'A':
+				return 0;
+			case 'C':
+				return 1;
+			case 'G':
+				return 2;
+			default:
+				return 3;
+			}
+		}
+
+		size_t ComplementCode(size_t code)
+		{
+			return code == END_CODE ? END_CODE : 3 - code;
+		}
+
+		bool Branching(size_t mask)
+		{
+			return (mask & (size_t(1) << END_CODE)) != 0 || (mask & (mask - 1)) != 0;
+		}
+
+		template<class Word>
+			Word ReverseComplement(Word kmer, size_t k)
+			{
+				Word ret = 0;
+				for(size_t i = 0; i < k; i++, kmer >>= 2)
+				{
+					ret = (ret << 2) | (3 - (kmer & 3));
+				}
+
+				return ret;
+			}
+
+		//Stable LSD radix sort of the triples (key, value, tag) by the lower "bits" bits of the key.
+		//Each thread counts digits of its own chunk, then puts the chunk into place
+		template<class Word>
+			void RadixSort(std::vector<Word> & key, std::vector<uint32_t> & value, std::vector<char> & tag, size_t bits)
+			{
+				size_t n = key.size();
+				int chunks = static_cast<int>(std::max<size_t>(1, std::min(GetThreadsNumber(), n / MIN_CHUNK_SIZE)));
+				std::vector<Word> keyBuffer(n);
+				std::vector<uint32_t> valueBuffer(n);
+				std::vector<char> tagBuffer(n);
+				std::vector<size_t> count(chunks * RADIX);
+				for(size_t shift = 0; shift < bits; shift += DIGIT_BITS)
+				{
+					std::fill(count.begin(), count.end(), 0);
+					#pragma omp parallel for schedule(static, 1)
+					for(int chunk = 0; chunk < chunks; chunk++)
+					{
+						size_t * now = &count[chunk * RADIX];
+						for(size_t i = n * chunk / chunks; i < n * (chunk + 1) / chunks; i++)
+						{
+							now[(key[i] >> shift) & (RADIX - 1)]++;
+						}
+					}
+
+					size_t total = 0;
+					for(size_t digit = 0; digit < RADIX; digit++)
+					{
+						for(int chunk = 0; chunk < chunks; chunk++)
+						{
+							size_t size = count[chunk * RADIX + digit];
+							count[chunk * RADIX + digit] = total;
+							total += size;
+						}
+					}
+
+					#pragma omp parallel for schedule(static, 1)
+					for(int chunk = 0; chunk < chunks; chunk++)
+					{
+						size_t * now = &count[chunk * RADIX];
+						for(size_t i = n * chunk / chunks; i < n * (chunk + 1) / chunks; i++)
+						{
+							size_t pos = now[(key[i] >> shift) & (RADIX - 1)]++;
+							keyBuffer[pos] = key[i];
+							valueBuffer[pos] = value[i];
+							tagBuffer[pos] = tag[i];
+						}
+					}
+
+					key.swap(keyBuffer);
+					value.swap(valueBuffer);
+					tag.swap(tagBuffer);
+				}
+			}
+	}
+
+	size_t IndexedSequence::EnumerateBifurcationsPacked(const std::vector<std::string> & data, std::vector<BifurcationInstance> & positiveBif, std::vector<BifurcationInstance> & negativeBif)
+	{
+		if(k_ * 2 <= sizeof(uint32_t) * 8)
+		{
+			return EnumerateBifurcationsPackedWord<uint32_t>(data, positiveBif, negativeBif);
+		}
+
+		return EnumerateBifurcationsPackedWord<uint64_t>(data, positiveBif, negativeBif);
+	}
+
+	//Each k-mer of the positive strand is packed into a word, its position and the
+	//neighbour chars are kept beside. The word holds the smaller of the k-mer and its
+	//reverse complement, so the sort groups all occurrences of a k-mer on both strands
+	//like the suffix array does.
+	template<class Word>
+		size_t IndexedSequence::EnumerateBifurcationsPackedWord(const std::vector<std::string> & data, std::vector<BifurcationInstance> & positiveBif, std::vector<BifurcationInstance> & negativeBif)
+		{
+			positiveBif.clear();
+			negativeBif.clear();
+			const Word mask = Word(-1) >> (sizeof(Word) * 8 - 2 * k_);
+			std::vector<size_t> cumSize(1, 0);
+			for(size_t chr = 0; chr < data.size(); chr++)
+			{
+				cumSize.push_back(cumSize.back() + data[chr].size());
+			}
+
+			std::vector<Word> key;
+			std::vector<char> tag;
+			std::vector<uint32_t> value;
+			{
+				PhaseTimer timer("kmer_packing");
+				key.reserve(cumSize.back());
+				tag.reserve(cumSize.back());
+				value.reserve(cumSize.back());
+				for(size_t chr = 0; chr < data.size(); chr++)
+				{
+					Word forward = 0;
+					Word reverse = 0;
+					const std::string & str = data[chr];
+					for(size_t i = 0; i < str.size(); i++)
+					{
+						Word code = static_cast<Word>(BaseCode(str[i]));
+						forward = ((forward << 2) | code) & mask;
+						reverse = (reverse >> 2) | ((3 - code) << (2 * (k_ - 1)));
+						if(i + 1 >= k_)
+						{
+							size_t pos = i + 1 - k_;
+							size_t before = pos > 0 ? BaseCode(str[pos - 1]) : END_CODE;
+							size_t after = i + 1 < str.size() ? BaseCode(str[i + 1]) : END_CODE;
+							key.push_back(std::min(forward, reverse));
+							tag.push_back(static_cast<char>((reverse < forward ? FLIPPED : 0) | (before << PREV_SHIFT) | after));
+							value.push_back(static_cast<uint32_t>(cumSize[chr] + pos));
+						}
+					}
+				}
+			}
+
+			{
+				PhaseTimer timer("radix_sort");
+				RadixSort(key, value, tag, 2 * k_);
+			}
+
+			PhaseTimer timer("bifurcation_enumeration");
+			std::vector<Word> bifurcation;
+			std::vector<std::pair<size_t, size_t> > group;
+			for(size_t start = 0; start < key.size(); )
+			{
+				size_t end = start;
+				size_t prev = 0;
+				size_t next = 0;
+				bool palindrome = ReverseComplement(key[start], k_) == key[start];
+				for(; end < key.size() && key[end] == key[start]; end++)
+				{
+					size_t before = (tag[end] >> PREV_SHIFT) & NEXT_MASK;
+					size_t after = tag[end] & NEXT_MASK;
+					if((tag[end] & FLIPPED) == 0 || palindrome)
+					{
+						prev |= size_t(1) << before;
+						next |= size_t(1) << after;
+					}
+
+					if((tag[end] & FLIPPED) != 0 || palindrome)
+					{
+						prev |= size_t(1) << ComplementCode(after);
+						next |= size_t(1) << ComplementCode(before);
+					}
+				}
+
+				if(Branching(prev) || Branching(next))
+				{
+					group.push_back(std::make_pair(start, end));
+					bifurcation.push_back(key[start]);
+					if(!palindrome)
+					{
+						bifurcation.push_back(ReverseComplement(key[start], k_));
+					}
+				}
+
+				start = end;
+			}
+
+			//Identifiers follow the lexicographic order of the k-mers, as in the suffix array
+			std::sort(bifurcation.begin(), bifurcation.end());
+			for(size_t i = 0; i < group.size(); i++)
+			{
+				Word kmer[] = {key[group[i].first], ReverseComplement(key[group[i].first], k_)};
+				Size id[2];
+				for(size_t j = 0; j < 2; j++)
+				{
+					id[j] = static_cast<Size>(std::lower_bound(bifurcation.begin(), bifurcation.end(), kmer[j]) - bifurcation.begin());
+				}
+
+				for(size_t j = group[i].first; j < group[i].second; j++)
+				{
+					size_t flipped = (tag[j] & FLIPPED) != 0 ? 1 : 0;
+					size_t global = value[j];
+					size_t chr = std::upper_bound(cumSize.begin(), cumSize.end(), global) - cumSize.begin() - 1;
+					size_t pos = global - cumSize[chr];
+					positiveBif.push_back(BifurcationInstance(id[flipped], static_cast<Size>(chr), static_cast<Size>(pos)));
+					negativeBif.push_back(BifurcationInstance(id[1 - flipped], static_cast<Size>(chr), static_cast<Size>(data[chr].size() - pos - k_)));
+				}
+			}
+
+			std::sort(positiveBif.begin(), positiveBif.end());
+			std::sort(negativeBif.begin(), negativeBif.end());
+			return bifurcation.size();
+		}
+}
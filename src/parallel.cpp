@@ -0,0 +1,95 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#include "parallel.h"
+#include "platform.h"
+
+namespace SyntenyFinder
+{
+	size_t GetThreadsNumber()
+	{
+	#ifdef _OPENMP
+		return static_cast<size_t>(omp_get_max_threads());
+	#else
+		return 1;
+	#endif
+	}
+
+	void SetThreadsNumber(size_t threads)
+	{
+	#ifdef _OPENMP
+		omp_set_num_threads(static_cast<int>(std::max(threads, size_t(1))));
+		//Output writers running concurrently may parallelize their own work
+		omp_set_max_active_levels(2);
+	#endif
+	}
+
+	size_t GetParallelLevel()
+	{
+	#ifdef _OPENMP
+		return static_cast<size_t>(omp_get_level());
+	#else
+		return 0;
+	#endif
+	}
+
+	size_t GetThreadId()
+	{
+	#ifdef _OPENMP
+		return static_cast<size_t>(omp_get_thread_num());
+	#else
+		return 0;
+	#endif
+	}
+
+	void SetNestedParallelism(bool enabled)
+	{
+	#ifdef _OPENMP
+		omp_set_max_active_levels(enabled ? 2 : 1);
+	#endif
+	}
+
+	void RunTasksConcurrently(std::vector<TimedTask> & task)
+	{
+		int n = static_cast<int>(task.size());
+		std::vector<std::string> error(task.size());
+		std::vector<char> failed(task.size(), 0);
+		//The threads are shared between the tasks, so the parallel regions started
+		//by the tasks don't run more threads than the outer team would
+		int threads = static_cast<int>(GetThreadsNumber());
+		int inner = std::max(1, threads / std::max(1, std::min(n, threads)));
+		#pragma omp parallel for schedule(dynamic, 1)
+		for(int i = 0; i < n; i++)
+		{
+		#ifdef _OPENMP
+			omp_set_num_threads(inner);
+		#endif
+			double start = GetWallClockTime();
+			try
+			{
+				task[i].body();
+			}
+			catch(std::exception & e)
+			{
+				failed[i] = 1;
+				error[i] = e.what();
+			}
+			catch(...)
+			{
+				failed[i] = 1;
+				error[i] = "unknown error in " + task[i].name;
+			}
+
+			task[i].elapsed = GetWallClockTime() - start;
+		}
+
+		std::vector<char>::iterator it = std::find(failed.begin(), failed.end(), 1);
+		if(it != failed.end())
+		{
+			throw std::runtime_error(error[it - failed.begin()]);
+		}
+	}
+}
@@ -0,0 +1,71 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include "common.h"
+
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
+
+namespace SyntenyFinder
+{
+	const size_t MIN_SORT_CHUNK_SIZE = 1 << 16;
+	size_t GetThreadsNumber();
+	void SetThreadsNumber(size_t threads);
+	//Number of enclosing parallel regions
+	size_t GetParallelLevel();
+	//Number of the calling thread in the innermost parallel region
+	size_t GetThreadId();
+	//Lets parallel regions started inside other parallel regions use more than one thread
+	void SetNestedParallelism(bool enabled);
+
+	struct TimedTask
+	{
+	public:
+		TimedTask() {}
+		TimedTask(const std::string & name, boost::function<void()> body): name(name), body(body), elapsed(0) {}
+		std::string name;
+		boost::function<void()> body;
+		double elapsed;
+	};
+
+	//Runs the tasks concurrently and measures the wall time spent by each task.
+	//Parallel regions inside a task get an equal share of the threads.
+	//If some tasks fail, the error of the first of them is rethrown after all the tasks are finished.
+	void RunTasksConcurrently(std::vector<TimedTask> & task);
+
+	//Sorts chunks of the vector concurrently, then merges them pairwise
+	template<class T>
+		void ParallelSort(std::vector<T> & data)
+		{
+			int chunks = static_cast<int>(std::max<size_t>(1, std::min(GetThreadsNumber(), data.size() / MIN_SORT_CHUNK_SIZE)));
+			std::vector<size_t> bound(chunks + 1);
+			for(int chunk = 0; chunk <= chunks; chunk++)
+			{
+				bound[chunk] = data.size() * chunk / chunks;
+			}
+
+			#pragma omp parallel for schedule(static, 1)
+			for(int chunk = 0; chunk < chunks; chunk++)
+			{
+				std::sort(data.begin() + bound[chunk], data.begin() + bound[chunk + 1]);
+			}
+
+			for(int step = 1; step < chunks; step *= 2)
+			{
+				#pragma omp parallel for schedule(static, 1)
+				for(int chunk = 0; chunk < chunks - step; chunk += 2 * step)
+				{
+					std::inplace_merge(data.begin() + bound[chunk], data.begin() + bound[chunk + step], data.begin() + bound[std::min(chunk + 2 * step, chunks)]);
+				}
+			}
+		}
+}
+
+#endif
@@ -0,0 +1,84 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#include "pipeline.h"
+#include "postprocessor.h"
+#include "runstats.h"
+
+namespace SyntenyFinder
+{
+	void FindSyntenyBlocks(const std::vector<FASTARecord> & chrList,
+		const PipelineParameters & parameters,
+		std::vector<std::vector<BlockInstance> > & history,
+		BlockFinder::ProgressCallBack progress,
+		StageCallBack stageCallBack)
+	{
+		const std::vector<std::pair<int, int> > & stage = parameters.stage;
+		history.assign(stage.size() + 1, std::vector<BlockInstance>());
+		std::auto_ptr<BlockFinder> finder(parameters.tempDir.empty() ? new BlockFinder(chrList) : new BlockFinder(chrList, parameters.tempDir));
+		Postprocessor processor(chrList, parameters.minBlockSize);
+		finder->SetWorkspace(parameters.workspace);
+		finder->SetBloomK(parameters.bloomK);
+		finder->SetFMIndex(parameters.fmIndex);
+		finder->SetMaxMultiplicity(parameters.maxMultiplicity);
+
+		int trimK = INT_MAX;
+		for(size_t i = 0; i < stage.size(); i++)
+		{
+			std::stringstream stageName;
+			stageName << "stage" << i + 1;
+			PhaseTimer stageTimer(stageName.str());
+			trimK = std::min(trimK, stage[i].first);
+			if(parameters.allStages && parameters.findBlocks)
+			{
+				{
+					PhaseTimer timer("synteny_blocks");
+					finder->GenerateSyntenyBlocks(stage[i].first, trimK, stage[i].first, history[i], parameters.sharedOnly);
+				}
+
+				if(parameters.postProcessing)
+				{
+					PhaseTimer timer("gluing");
+					processor.GlueStripes(history[i]);
+				}
+			}
+
+			if(stageCallBack)
+			{
+				stageCallBack(i, *finder);
+			}
+
+			finder->PerformGraphSimplifications(stage[i].first, stage[i].second, parameters.maxIterations, progress);
+		}
+
+		trimK = std::min(trimK, static_cast<int>(parameters.minBlockSize));
+		size_t lastK = parameters.lastK > 0 ? parameters.lastK : std::min(stage.size() > 0 ? stage.back().first : INT_MAX, static_cast<int>(parameters.minBlockSize));
+		if(stageCallBack)
+		{
+			stageCallBack(stage.size(), *finder);
+		}
+
+		if(parameters.findBlocks)
+		{
+			{
+				PhaseTimer timer("synteny_blocks");
+				finder->GenerateSyntenyBlocks(lastK, trimK, parameters.minBlockSize, history.back(), parameters.sharedOnly, progress);
+			}
+
+			if(parameters.postProcessing)
+			{
+				PhaseTimer timer("gluing");
+				processor.GlueStripes(history.back());
+			}
+
+			if(parameters.correctBoundaries)
+			{
+				PhaseTimer timer("boundary_correction");
+				processor.ImproveBlockBoundaries(history.back(), parameters.referenceChrId);
+			}
+		}
+	}
+}
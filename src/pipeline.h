@@ -0,0 +1,59 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+#include "blockfinder.h"
+
+namespace SyntenyFinder
+{
+	struct PipelineParameters
+	{
+		//Pairs (k, minimum branch size) of the simplification stages
+		std::vector<std::pair<int, int> > stage;
+		size_t minBlockSize;
+		size_t maxIterations;
+		//Bifurcations with more occurrences are not simplified, 0 means no limit
+		size_t maxMultiplicity;
+		//K used for the final blocks, 0 means min(last stage k, minBlockSize)
+		size_t lastK;
+		bool sharedOnly;
+		bool postProcessing;
+		bool correctBoundaries;
+		//Compute blocks after each stage, not only the final ones
+		bool allStages;
+		bool findBlocks;
+		//Directory for temporary files, empty means that all computations are in RAM
+		std::string tempDir;
+		//Sequences of the reference genome, used by the boundaries correction
+		std::set<size_t> referenceChrId;
+		//Buffers reused between the jobs of one worker, may be null
+		Workspace * workspace;
+		//Stages with k >= bloomK enumerate vertices with a Bloom filter, 0 means never
+		size_t bloomK;
+		//Enumerate vertices with an FM-index of the positive strand
+		bool fmIndex;
+		PipelineParameters(): minBlockSize(5000), maxIterations(4), maxMultiplicity(0), lastK(0), sharedOnly(false), postProcessing(true),
+			correctBoundaries(false), allStages(false), findBlocks(true), workspace(0), bloomK(0), fmIndex(false) {}
+	};
+
+	//Called before the simplification stage "stage" and with stage == number of stages
+	//before the final blocks are found
+	typedef boost::function<void(size_t, BlockFinder&)> StageCallBack;
+
+	//Runs simplification, block search, gluing and boundaries correction. The function
+	//doesn't touch global state, so many jobs can run concurrently in one process.
+	//history[i] contains blocks after stage i (if allStages is set), history.back()
+	//contains the final blocks. The blocks refer to chrList, so it must outlive them.
+	void FindSyntenyBlocks(const std::vector<FASTARecord> & chrList,
+		const PipelineParameters & parameters,
+		std::vector<std::vector<BlockInstance> > & history,
+		BlockFinder::ProgressCallBack progress = BlockFinder::ProgressCallBack(),
+		StageCallBack stageCallBack = StageCallBack());
+}
+
+#endif
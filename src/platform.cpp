@@ -6,6 +6,17 @@
 
 #include "platform.h"
 
+#ifdef _WIN32
+	#define NOMINMAX
+	#include <windows.h>
+	#include <psapi.h>
+	#pragma comment(lib, "psapi.lib")
+#else
+	#include <pthread.h>
+	#include <sys/time.h>
+	#include <sys/resource.h>
+#endif
+
 namespace SyntenyFinder
 {
 	std::vector<std::string> GetResourceDirs()
@@ -41,6 +52,86 @@ namespace SyntenyFinder
 		}
 	}
 
+	double GetWallClockTime()
+	{
+	#ifdef _WIN32
+		LARGE_INTEGER frequency;
+		LARGE_INTEGER counter;
+		QueryPerformanceFrequency(&frequency);
+		QueryPerformanceCounter(&counter);
+		return static_cast<double>(counter.QuadPart) / frequency.QuadPart;
+	#else
+		timeval now;
+		gettimeofday(&now, 0);
+		return now.tv_sec + now.tv_usec * 1e-6;
+	#endif
+	}
+
+	double GetCPUTime()
+	{
+		return static_cast<double>(clock()) / CLOCKS_PER_SEC;
+	}
+
+	size_t GetPeakMemoryUsage()
+	{
+	#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return counters.PeakWorkingSetSize;
+	#else
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+	#ifdef __APPLE__
+		return usage.ru_maxrss;
+	#else
+		return static_cast<size_t>(usage.ru_maxrss) * 1024;
+	#endif
+	#endif
+	}
+
+	Mutex::Mutex()
+	{
+	#ifdef _WIN32
+		CRITICAL_SECTION * section = new CRITICAL_SECTION;
+		InitializeCriticalSection(section);
+		handle_ = section;
+	#else
+		pthread_mutex_t * mutex = new pthread_mutex_t;
+		pthread_mutex_init(mutex, 0);
+		handle_ = mutex;
+	#endif
+	}
+
+	Mutex::~Mutex()
+	{
+	#ifdef _WIN32
+		DeleteCriticalSection(static_cast<CRITICAL_SECTION*>(handle_));
+		delete static_cast<CRITICAL_SECTION*>(handle_);
+	#else
+		pthread_mutex_destroy(static_cast<pthread_mutex_t*>(handle_));
+		delete static_cast<pthread_mutex_t*>(handle_);
+	#endif
+	}
+
+	void Mutex::Lock()
+	{
+	#ifdef _WIN32
+		EnterCriticalSection(static_cast<CRITICAL_SECTION*>(handle_));
+	#else
+		pthread_mutex_lock(static_cast<pthread_mutex_t*>(handle_));
+	#endif
+	}
+
+	void Mutex::Unlock()
+	{
+	#ifdef _WIN32
+		LeaveCriticalSection(static_cast<CRITICAL_SECTION*>(handle_));
+	#else
+		pthread_mutex_unlock(static_cast<pthread_mutex_t*>(handle_));
+	#endif
+	}
+
+	Mutex TempFile::registerMutex_;
 	std::map<std::string, FILE*> TempFile::register_;
 
 	TempFile::TempFile()
@@ -49,6 +140,9 @@ namespace SyntenyFinder
 
 	TempFile::TempFile(const std::string & directory): handle_(0)
 	{
+		//The names are generated and registered under the lock, so concurrent
+		//jobs never pick the same file
+		MutexLock lock(registerMutex_);
 		for(size_t attempt = 0; attempt < 1000; attempt++)
 		{
 			std::string fileName = "Sib_";
@@ -82,6 +176,7 @@ namespace SyntenyFinder
 
 	void TempFile::Cleanup()
 	{
+		MutexLock lock(registerMutex_);
 		for(std::map<std::string, FILE*>::iterator it = register_.begin(); it != register_.end(); ++it)
 		{
 			if(it->second != 0)
@@ -100,6 +195,7 @@ namespace SyntenyFinder
 	{
 		if(handle_ != 0)
 		{
+			MutexLock lock(registerMutex_);
 			fclose(handle_);
 			remove(path_.c_str());
 			register_.erase(path_);
@@ -13,6 +13,39 @@ namespace SyntenyFinder
 {
 	std::vector<std::string> GetResourceDirs();
 	void CreateOutDirectory(const std::string & path);
+	double GetWallClockTime();
+	double GetCPUTime();
+	size_t GetPeakMemoryUsage();
+
+	class Mutex
+	{
+	public:
+		Mutex();
+		~Mutex();
+		void Lock();
+		void Unlock();
+	private:
+		DISALLOW_COPY_AND_ASSIGN(Mutex);
+		void * handle_;
+	};
+
+	class MutexLock
+	{
+	public:
+		explicit MutexLock(Mutex & mutex): mutex_(mutex)
+		{
+			mutex_.Lock();
+		}
+
+		~MutexLock()
+		{
+			mutex_.Unlock();
+		}
+
+	private:
+		DISALLOW_COPY_AND_ASSIGN(MutexLock);
+		Mutex & mutex_;
+	};
 
 	class TempFile
 	{
@@ -28,6 +61,7 @@ namespace SyntenyFinder
 	private:
 		FILE * handle_;
 		std::string path_;
+		static Mutex registerMutex_;
 		static std::map<std::string, FILE*> register_;
 	};
 }
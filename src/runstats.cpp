@@ -0,0 +1,262 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#include "runstats.h"
+#include "platform.h"
+#include "parallel.h"
+
+namespace SyntenyFinder
+{
+	THREAD_LOCAL uint64_t * localCounter = 0;
+	THREAD_LOCAL size_t hotPathDepth = 0;
+
+	namespace
+	{
+		const char * COUNTER_NAME[] = {"get_bifurcation", "replace", "scratch_allocation", "hot_path_allocation"};
+
+		struct PhaseRecord
+		{
+			std::string path;
+			size_t calls;
+			double wallTime;
+			double cpuTime;
+			size_t peakMemory;
+			bool timedElsewhere;
+			std::vector<uint64_t> counter;
+			std::map<std::string, std::vector<size_t> > series;
+			PhaseRecord() {}
+			PhaseRecord(const std::string & path, bool timedElsewhere): path(path), calls(0), wallTime(0), cpuTime(0),
+				peakMemory(0), timedElsewhere(timedElsewhere), counter(HOT_COUNTERS_NUMBER, 0) {}
+		};
+
+		//Statistics of the run started by the thread, each thread that calls
+		//ResetRunStats gets its own, so concurrent jobs don't mix their phases
+		struct RunStats
+		{
+			size_t level;
+			double runStartTime;
+			std::vector<std::string> phaseStack;
+			std::vector<PhaseRecord> phaseRecord;
+			std::map<std::string, size_t> phaseIndex;
+
+			std::string CurrentPath() const
+			{
+				std::string ret;
+				for(size_t i = 0; i < phaseStack.size(); i++)
+				{
+					ret += (i > 0 ? "/" : "") + phaseStack[i];
+				}
+
+				return ret;
+			}
+
+			PhaseRecord & GetRecord(const std::string & path, bool timedElsewhere)
+			{
+				std::map<std::string, size_t>::iterator it = phaseIndex.find(path);
+				if(it == phaseIndex.end())
+				{
+					it = phaseIndex.insert(std::make_pair(path, phaseRecord.size())).first;
+					phaseRecord.push_back(PhaseRecord(path, timedElsewhere));
+				}
+
+				return phaseRecord[it->second];
+			}
+		};
+
+		THREAD_LOCAL RunStats * runStats = 0;
+		Mutex counterMutex;
+		std::vector<uint64_t*> counterBlock;
+
+		bool Recording()
+		{
+			return runStats != 0 && GetParallelLevel() == runStats->level;
+		}
+
+		std::vector<uint64_t> SumCounters()
+		{
+			std::vector<uint64_t> ret(HOT_COUNTERS_NUMBER, 0);
+			MutexLock lock(counterMutex);
+			for(size_t i = 0; i < counterBlock.size(); i++)
+			{
+				for(size_t j = 0; j < HOT_COUNTERS_NUMBER; j++)
+				{
+					ret[j] += counterBlock[i][j];
+				}
+			}
+
+			return ret;
+		}
+
+		std::string Escape(const std::string & str)
+		{
+			std::string ret;
+			for(size_t i = 0; i < str.size(); i++)
+			{
+				if(str[i] == '"' || str[i] == '\\')
+				{
+					ret.push_back('\\');
+				}
+
+				ret.push_back(str[i]);
+			}
+
+			return ret;
+		}
+
+		void WriteCounters(std::ostream & out, const std::vector<uint64_t> & counter)
+		{
+			out << "{";
+			for(size_t i = 0; i < HOT_COUNTERS_NUMBER; i++)
+			{
+				out << (i > 0 ? ", " : "") << "\"" << COUNTER_NAME[i] << "\": " << counter[i];
+			}
+
+			out << "}";
+		}
+	}
+
+	uint64_t * RegisterLocalCounters()
+	{
+		uint64_t * ret = new uint64_t[HOT_COUNTERS_NUMBER];
+		std::fill(ret, ret + HOT_COUNTERS_NUMBER, 0);
+		MutexLock lock(counterMutex);
+		counterBlock.push_back(ret);
+		return ret;
+	}
+
+	uint64_t GetHotCounter(HotCounter counter)
+	{
+		return SumCounters()[counter];
+	}
+
+	PhaseTimer::PhaseTimer(const std::string & name): active_(Recording())
+	{
+		if(active_)
+		{
+			runStats->phaseStack.push_back(name);
+			runStats->GetRecord(runStats->CurrentPath(), false);
+			startCounter_ = SumCounters();
+			startCPUTime_ = GetCPUTime();
+			startWallTime_ = GetWallClockTime();
+		}
+	}
+
+	PhaseTimer::~PhaseTimer()
+	{
+		if(active_)
+		{
+			PhaseRecord & record = runStats->GetRecord(runStats->CurrentPath(), false);
+			std::vector<uint64_t> counter = SumCounters();
+			record.calls++;
+			record.wallTime += GetWallClockTime() - startWallTime_;
+			record.cpuTime += GetCPUTime() - startCPUTime_;
+			record.peakMemory = std::max(record.peakMemory, GetPeakMemoryUsage());
+			for(size_t i = 0; i < HOT_COUNTERS_NUMBER; i++)
+			{
+				record.counter[i] += counter[i] - startCounter_[i];
+			}
+
+			runStats->phaseStack.pop_back();
+		}
+	}
+
+	void ResetRunStats()
+	{
+		if(runStats == 0)
+		{
+			runStats = new RunStats;
+		}
+
+		runStats->level = GetParallelLevel();
+		runStats->runStartTime = GetWallClockTime();
+		runStats->phaseStack.clear();
+		runStats->phaseRecord.clear();
+		runStats->phaseIndex.clear();
+	}
+
+	void RecordPhaseValue(const std::string & series, size_t value)
+	{
+		if(Recording() && !runStats->phaseStack.empty())
+		{
+			runStats->GetRecord(runStats->CurrentPath(), false).series[series].push_back(value);
+		}
+	}
+
+	void RecordPhaseWallTime(const std::string & name, double wallTime)
+	{
+		if(Recording())
+		{
+			runStats->phaseStack.push_back(name);
+			PhaseRecord & record = runStats->GetRecord(runStats->CurrentPath(), true);
+			record.calls++;
+			record.wallTime += wallTime;
+			runStats->phaseStack.pop_back();
+		}
+	}
+
+	double GetRunWallTime()
+	{
+		return runStats != 0 ? GetWallClockTime() - runStats->runStartTime : 0;
+	}
+
+	std::vector<std::pair<std::string, double> > GetPhaseWallTimes()
+	{
+		std::vector<std::pair<std::string, double> > ret;
+		for(size_t i = 0; runStats != 0 && i < runStats->phaseRecord.size(); i++)
+		{
+			ret.push_back(std::make_pair(runStats->phaseRecord[i].path, runStats->phaseRecord[i].wallTime));
+		}
+
+		return ret;
+	}
+
+	void WriteRunStats(const std::string & fileName, size_t threads)
+	{
+		std::ofstream out(fileName.c_str());
+		if(!out)
+		{
+			throw std::runtime_error(("Cannot open file " + fileName).c_str());
+		}
+
+		out.setf(std::ios_base::fixed);
+		out.precision(3);
+		out << "{" << std::endl;
+		out << "\t\"version\": \"" << VERSION << "\"," << std::endl;
+		out << "\t\"threads\": " << threads << "," << std::endl;
+		out << "\t\"wall_time\": " << GetRunWallTime() << "," << std::endl;
+		out << "\t\"cpu_time\": " << GetCPUTime() << "," << std::endl;
+		out << "\t\"peak_rss\": " << GetPeakMemoryUsage() << "," << std::endl;
+		out << "\t\"counters\": ";
+		WriteCounters(out, SumCounters());
+		out << "," << std::endl << "\t\"phases\": [" << std::endl;
+		const std::vector<PhaseRecord> & phaseRecord = runStats != 0 ? runStats->phaseRecord : std::vector<PhaseRecord>();
+		for(size_t i = 0; i < phaseRecord.size(); i++)
+		{
+			const PhaseRecord & record = phaseRecord[i];
+			out << "\t\t{\"name\": \"" << Escape(record.path) << "\", \"calls\": " << record.calls << ", \"wall_time\": " << record.wallTime;
+			if(!record.timedElsewhere)
+			{
+				out << ", \"cpu_time\": " << record.cpuTime << ", \"peak_rss\": " << record.peakMemory << ", \"counters\": ";
+				WriteCounters(out, record.counter);
+			}
+
+			for(std::map<std::string, std::vector<size_t> >::const_iterator it = record.series.begin(); it != record.series.end(); ++it)
+			{
+				out << ", \"" << Escape(it->first) << "\": [";
+				for(size_t j = 0; j < it->second.size(); j++)
+				{
+					out << (j > 0 ? ", " : "") << it->second[j];
+				}
+
+				out << "]";
+			}
+
+			out << "}" << (i + 1 < phaseRecord.size() ? "," : "") << std::endl;
+		}
+
+		out << "\t]" << std::endl << "}" << std::endl;
+	}
+}
@@ -0,0 +1,113 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#ifndef _RUN_STATS_H_
+#define _RUN_STATS_H_
+
+#include "common.h"
+
+#ifdef _MSC_VER
+	#define THREAD_LOCAL __declspec(thread)
+#else
+	#define THREAD_LOCAL __thread
+#endif
+
+namespace SyntenyFinder
+{
+	enum HotCounter
+	{
+		GET_BIFURCATION_COUNTER,
+		REPLACE_COUNTER,
+		SCRATCH_ALLOCATION_COUNTER,
+		HOT_PATH_ALLOCATION_COUNTER,
+		HOT_COUNTERS_NUMBER
+	};
+
+	//Each thread increments its own block of counters, the blocks are summed up
+	//only when a phase starts or ends
+	extern THREAD_LOCAL uint64_t * localCounter;
+	uint64_t * RegisterLocalCounters();
+
+	inline void IncrementCounter(HotCounter counter)
+	{
+		if(localCounter == 0)
+		{
+			localCounter = RegisterLocalCounters();
+		}
+
+		localCounter[counter]++;
+	}
+
+	//Code that must not touch the heap in the steady state marks itself with a
+	//HotPathScope. A program that replaces the global operator new calls
+	//CountHeapAllocation from it, and every allocation made inside a scope is
+	//counted as "hot_path_allocation". Other programs always report zero.
+	extern THREAD_LOCAL size_t hotPathDepth;
+
+	class HotPathScope
+	{
+	public:
+		HotPathScope()
+		{
+			if(localCounter == 0)
+			{
+				localCounter = RegisterLocalCounters();
+			}
+
+			hotPathDepth++;
+		}
+
+		~HotPathScope()
+		{
+			hotPathDepth--;
+		}
+
+	private:
+		DISALLOW_COPY_AND_ASSIGN(HotPathScope);
+	};
+
+	inline void CountHeapAllocation()
+	{
+		if(hotPathDepth > 0)
+		{
+			localCounter[HOT_PATH_ALLOCATION_COUNTER]++;
+		}
+	}
+
+	//Sum of the counter over all threads since the start of the process
+	uint64_t GetHotCounter(HotCounter counter);
+
+	//Measures wall time, CPU time, peak memory usage and hot counters of a phase of
+	//the run. Phases may be nested, a nested phase is reported as "outer/inner". All
+	//the calls of a phase with the same path are accumulated into one record.
+	//Phases are recorded only by the threads that called ResetRunStats and not
+	//inside parallel regions started after that. Hot counters are process-wide.
+	class PhaseTimer
+	{
+	public:
+		explicit PhaseTimer(const std::string & name);
+		~PhaseTimer();
+	private:
+		DISALLOW_COPY_AND_ASSIGN(PhaseTimer);
+		bool active_;
+		double startWallTime_;
+		double startCPUTime_;
+		std::vector<uint64_t> startCounter_;
+	};
+
+	//Starts recording of the run statistics by the calling thread
+	void ResetRunStats();
+	//Appends a value to the named series of the innermost running phase
+	void RecordPhaseValue(const std::string & series, size_t value);
+	//Records a nested phase that was timed elsewhere (e.g. a concurrently running task)
+	void RecordPhaseWallTime(const std::string & name, double wallTime);
+	double GetRunWallTime();
+	//Wall times of the recorded phases in order of their first start
+	std::vector<std::pair<std::string, double> > GetPhaseWallTimes();
+	void WriteRunStats(const std::string & fileName, size_t threads);
+}
+
+#endif
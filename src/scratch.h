@@ -0,0 +1,156 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#ifndef _SCRATCH_H_
+#define _SCRATCH_H_
+
+#include "runstats.h"
+
+namespace SyntenyFinder
+{
+	//Bump allocator for short-lived temporaries. Memory is handed out from big
+	//blocks and is given back only all at once by Reset. After a reset the blocks
+	//are merged into one, so a round that needs no more memory than the previous
+	//ones does not call the heap. Each heap call is counted as "scratch_allocation".
+	//An arena may be used by only one thread at a time.
+	class ScratchArena
+	{
+	public:
+		ScratchArena(): used_(0) {}
+		~ScratchArena()
+		{
+			Free();
+		}
+
+		void * Allocate(size_t size)
+		{
+			size = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+			if(block_.empty() || used_ + size > block_.back().second)
+			{
+				AddBlock(std::max(size, block_.empty() ? MIN_BLOCK_SIZE : block_.back().second * 2));
+			}
+
+			void * ret = block_.back().first + used_;
+			used_ += size;
+			return ret;
+		}
+
+		//Invalidates everything allocated so far
+		void Reset()
+		{
+			if(block_.size() > 1)
+			{
+				size_t total = 0;
+				for(size_t i = 0; i < block_.size(); i++)
+				{
+					total += block_[i].second;
+				}
+
+				Free();
+				AddBlock(total);
+			}
+
+			used_ = 0;
+		}
+
+	private:
+		DISALLOW_COPY_AND_ASSIGN(ScratchArena);
+		static const size_t ALIGNMENT = 16;
+		static const size_t MIN_BLOCK_SIZE = 1 << 16;
+		size_t used_;
+		std::vector<std::pair<char*, size_t> > block_;
+
+		void AddBlock(size_t size)
+		{
+			IncrementCounter(SCRATCH_ALLOCATION_COUNTER);
+			block_.push_back(std::make_pair(new char[size], size));
+			used_ = 0;
+		}
+
+		void Free()
+		{
+			for(size_t i = 0; i < block_.size(); i++)
+			{
+				delete [] block_[i].first;
+			}
+
+			block_.clear();
+		}
+	};
+
+	//STL allocator on top of an arena, deallocation does nothing
+	template<class T>
+		class ScratchAllocator
+		{
+		public:
+			typedef T value_type;
+			typedef T * pointer;
+			typedef const T * const_pointer;
+			typedef T & reference;
+			typedef const T & const_reference;
+			typedef size_t size_type;
+			typedef ptrdiff_t difference_type;
+			template<class U>
+				struct rebind
+				{
+					typedef ScratchAllocator<U> other;
+				};
+
+			explicit ScratchAllocator(ScratchArena & arena): arena_(&arena) {}
+			template<class U>
+				ScratchAllocator(const ScratchAllocator<U> & other): arena_(other.GetArena()) {}
+
+			pointer allocate(size_type n, const void * = 0)
+			{
+				return static_cast<pointer>(arena_->Allocate(n * sizeof(T)));
+			}
+
+			void deallocate(pointer, size_type) {}
+
+			size_type max_size() const
+			{
+				return size_type(-1) / sizeof(T);
+			}
+
+			pointer address(reference value) const
+			{
+				return &value;
+			}
+
+			const_pointer address(const_reference value) const
+			{
+				return &value;
+			}
+
+			ScratchArena * GetArena() const
+			{
+				return arena_;
+			}
+
+			template<class U>
+				bool operator == (const ScratchAllocator<U> & other) const
+				{
+					return arena_ == other.GetArena();
+				}
+
+			template<class U>
+				bool operator != (const ScratchAllocator<U> & other) const
+				{
+					return arena_ != other.GetArena();
+				}
+
+		private:
+			ScratchArena * arena_;
+		};
+
+	template<class T>
+		struct ScratchVector
+		{
+			typedef std::vector<T, ScratchAllocator<T> > Type;
+		};
+}
+
+#endif
@@ -5,6 +5,7 @@
 //****************************************************************************
 
 #include "blockfinder.h"
+#include "parallel.h"
 
 namespace SyntenyFinder
 {
@@ -22,6 +23,41 @@ namespace SyntenyFinder
 			sprintf(&buf[0], "[color=\"%s\", label=\"(%i, %i)\"];", color.c_str(), static_cast<int>(chr), static_cast<int>(pos));
 			out << " " << buf << std::endl;
 		}
+
+		//Moves the iterator to the next bifurcation or to the end, returns the number of steps made
+		template<DNASequence::Direction direction>
+			size_t NextBifurcation(const BifurcationStorage & bifStorage, StrandIterator & start, StrandIterator end)
+			{
+				size_t step = 1;
+				DNASequence::FixedStrandIterator<direction> it(start);
+				DNASequence::FixedStrandIterator<direction> last(end);
+				for(++it; it != last && bifStorage.GetBifurcation(it) == BifurcationStorage::NO_BIFURCATION; ++it, ++step);
+				start = it.Get();
+				return step;
+			}
+
+		size_t NextBifurcation(const BifurcationStorage & bifStorage, StrandIterator & start, StrandIterator end)
+		{
+			return start.GetDirection() == DNASequence::positive ? NextBifurcation<DNASequence::positive>(bifStorage, start, end) :
+				NextBifurcation<DNASequence::negative>(bifStorage, start, end);
+		}
+
+		//Strands of long chromosomes are listed by pieces of this size
+		const size_t EDGE_PIECE_SIZE = 1 << 20;
+		//Lines of the condensed graph formatted at once
+		const size_t OUTPUT_BATCH_SIZE = 1 << 16;
+
+		struct EdgePiece
+		{
+			EdgePiece() {}
+			EdgePiece(DNASequence::Direction direction, size_t chr, size_t length, size_t from, size_t to):
+				direction(direction), chr(chr), length(length), from(from), to(to) {}
+			DNASequence::Direction direction;
+			size_t chr;
+			size_t length;
+			size_t from;
+			size_t to;
+		};
 	}
 	
 	void BlockFinder::PrintRaw(const DNASequence & sequence, std::ostream & out)
@@ -53,57 +89,104 @@ namespace SyntenyFinder
 		std::cerr << std::endl;
 	}
 
-	void BlockFinder::ListEdges(const DNASequence & sequence, const BifurcationStorage & bifStorage, size_t k, std::vector<Edge> & edge) const
+	//The sequence and the bifurcations are only read here, so the strands of the
+	//chromosomes are cut into pieces listed by separate tasks. A piece lists the
+	//edges starting inside it, the parts are joined in the old order
+	void BlockFinder::ListEdges(const DNASequence & sequence, const BifurcationStorage & bifStorage, size_t k, size_t minSize, EdgeTable & edge) const
 	{
-		edge.clear();
+		std::vector<EdgePiece> piece;
 		for(size_t strand = 0; strand < 2; strand++)
 		{
 			for(size_t chr = 0; chr < sequence.ChrNumber(); chr++)
 			{
-				size_t pos = 0;				
-				StrandIterator start = sequence.Begin((DNASequence::Direction)strand, chr);
-				StrandIterator end = sequence.End((DNASequence::Direction)strand, chr);				
-				size_t prevVertex = bifStorage.GetBifurcation(start);
-				size_t length = std::distance(start, end);
-				for(; start != end; )
+				size_t length = sequence.GlobalIndex(sequence.PositiveEnd(chr)) - sequence.GlobalIndex(sequence.PositiveBegin(chr));
+				for(size_t from = 0; from < length; from += EDGE_PIECE_SIZE)
+				{
+					piece.push_back(EdgePiece(static_cast<DNASequence::Direction>(strand), chr, length, from, std::min(length, from + EDGE_PIECE_SIZE)));
+				}
+			}
+		}
+
+		std::vector<EdgeTable> part(piece.size());
+		#pragma omp parallel for schedule(dynamic, 1)
+		for(int task = 0; task < static_cast<int>(piece.size()); task++)
+		{
+			const EdgePiece & now = piece[task];
+			size_t pos = now.from;
+			StrandIterator start = sequence.Begin(now.direction, now.chr);
+			StrandIterator end = sequence.End(now.direction, now.chr);
+			//Edges of the pieces but the first one start at bifurcations
+			if(now.from > 0)
+			{
+				start = sequence.AdvanceForward(start, now.from);
+				if(bifStorage.GetBifurcation(start) == BifurcationStorage::NO_BIFURCATION)
 				{
-					size_t step = 1;				
-					StrandIterator origin = start;
-					for(++start; start != end && bifStorage.GetBifurcation(start) == BifurcationStorage::NO_BIFURCATION; ++start, ++step);
-					if(start != end)
+					pos += NextBifurcation(bifStorage, start, end);
+				}
+			}
+
+			size_t prevVertex = start != end ? bifStorage.GetBifurcation(start) : BifurcationStorage::NO_BIFURCATION;
+			while(start != end && pos < now.to)
+			{
+				StrandIterator origin = start;
+				size_t step = NextBifurcation(bifStorage, start, end);
+				if(start != end)
+				{
+					size_t nowVertex = bifStorage.GetBifurcation(start);
+					std::pair<size_t, size_t> coord = sequence.SpellOriginal(origin, sequence.AdvanceForward(start, k));
+					if(coord.second - coord.first >= minSize)
 					{
-						char firstChar = *AdvanceForward(origin, k);
-						size_t nowVertex = bifStorage.GetBifurcation(start);
-						std::pair<size_t, size_t> coord = sequence.SpellOriginal(origin, AdvanceForward(start, k));
-						size_t actualPos = strand == 0 ? pos : length - (pos + step + k);
-						edge.push_back(Edge(chr, start.GetDirection(), prevVertex, nowVertex, actualPos, step + k, coord.first, coord.second - coord.first, firstChar));
-						prevVertex = nowVertex;
-						pos += step;
+						char firstChar = *sequence.AdvanceForward(origin, k);
+						size_t actualPos = now.direction == DNASequence::positive ? pos : now.length - (pos + step + k);
+						part[task].PushBack(now.chr, now.direction, prevVertex, nowVertex, actualPos, step + k, coord.first, coord.second - coord.first, firstChar);
 					}
+
+					prevVertex = nowVertex;
+					pos += step;
 				}
 			}
 		}
+
+		edge.Clear();
+		for(size_t i = 0; i < part.size(); i++)
+		{
+			edge.Append(part[i]);
+			EdgeTable().Swap(part[i]);
+		}
 	}
 
 	void BlockFinder::SerializeCondensedGraph(size_t k, std::ostream & out, ProgressCallBack f)
 	{
-		IndexedSequence iseq(rawSeq_, originalPos_, k, tempDir_);
+		IndexedSequence iseq(rawSeq_, originalPos_, k, tempDir_, false, workspace_, GetEnumeration(k));
 		out << "digraph G" << std::endl << "{" << std::endl;
 		out << "rankdir=LR" << std::endl;
-		std::vector<Edge> edge;
-		ListEdges(iseq.Sequence(), iseq.BifStorage(), k, edge);
-		for(size_t i = 0; i < edge.size(); i++)
+		EdgeTable table;
+		ListEdges(iseq.Sequence(), iseq.BifStorage(), k, 0, table);
+		//The lines of a batch are formatted concurrently and written in order
+		std::vector<std::string> line;
+		for(size_t batch = 0; batch < table.Size(); batch += OUTPUT_BATCH_SIZE)
 		{
-			char buf[1 << 8];
-			std::string color = edge[i].GetDirection() == DNASequence::positive ? "blue" : "red";
-			int uchr = static_cast<int>(edge[i].GetChr());
-			int uorpos = static_cast<int>(edge[i].GetOriginalPosition());
-			int uorlength = static_cast<int>(edge[i].GetOriginalLength());
-			int upos = static_cast<int>(edge[i].GetActualPosition());
-			int ulength = static_cast<int>(edge[i].GetActualLength());
-			out << edge[i].GetStartVertex() << " -> " << edge[i].GetEndVertex();
-			sprintf(&buf[0], "[color=\"%s\", label=\"chr=%i pos=%i len=%i orpos=%i orlen=%i  ch='%c'\"];", color.c_str(), uchr, upos, ulength, uorpos, uorlength, edge[i].GetFirstChar());
-			out << " " << buf << std::endl;
+			line.resize(std::min(OUTPUT_BATCH_SIZE, table.Size() - batch));
+			#pragma omp parallel for schedule(static)
+			for(int i = 0; i < static_cast<int>(line.size()); i++)
+			{
+				char buf[1 << 8];
+				Edge edge = table[batch + i];
+				const char * color = edge.GetDirection() == DNASequence::positive ? "blue" : "red";
+				int uchr = static_cast<int>(edge.GetChr());
+				int uorpos = static_cast<int>(edge.GetOriginalPosition());
+				int uorlength = static_cast<int>(edge.GetOriginalLength());
+				int upos = static_cast<int>(edge.GetActualPosition());
+				int ulength = static_cast<int>(edge.GetActualLength());
+				sprintf(&buf[0], "%llu -> %llu [color=\"%s\", label=\"chr=%i pos=%i len=%i orpos=%i orlen=%i  ch='%c'\"];\n", static_cast<ull>(edge.GetStartVertex()),
+					static_cast<ull>(edge.GetEndVertex()), color, uchr, upos, ulength, uorpos, uorlength, edge.GetFirstChar());
+				line[i] = buf;
+			}
+
+			for(size_t i = 0; i < line.size(); i++)
+			{
+				out << line[i];
+			}
 		}
 
 		out << "}" << std::endl;
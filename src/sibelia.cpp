@@ -5,10 +5,9 @@
 //****************************************************************************
 
 #include <tclap/CmdLine.h>
-#include "postprocessor.h"
+#include "pipeline.h"
 #include "util.h"
-
-const std::string VERSION("3.0.7");
+#include "runstats.h"
 
 class GreaterIntegerConstraint: public TCLAP::Constraint<int>
 {
@@ -40,6 +39,420 @@ private:
 	std::string typeDesc_;
 };
 
+typedef boost::function<void(const SyntenyFinder::BlockIndex&, const std::string&)> CoordsWriter;
+
+void WriteStageCoords(CoordsWriter writer, const std::vector<SyntenyFinder::BlockInstance> & blockList, size_t chrNumber, const std::string & fileName)
+{
+	writer(SyntenyFinder::BlockIndex(blockList, chrNumber), fileName);
+}
+
+void AddCoordsWriters(std::vector<SyntenyFinder::TimedTask> & task,
+					  CoordsWriter writer,
+					  const std::vector<std::vector<SyntenyFinder::BlockInstance> > & history,
+					  const SyntenyFinder::BlockIndex & index,
+					  bool allStages,
+					  const std::string & prefix,
+					  const std::string & extension)
+{
+	if(allStages)
+	{
+		for(size_t i = 0; i + 1 < history.size(); i++)
+		{
+			std::stringstream file;
+			file << prefix << i << extension;
+			task.push_back(SyntenyFinder::TimedTask(file.str(), boost::bind(WriteStageCoords, writer, boost::cref(history[i]), index.ChrNumber(), file.str())));
+		}
+
+		std::stringstream file;
+		file << prefix << history.size() - 1 << extension;
+		task.push_back(SyntenyFinder::TimedTask(file.str(), boost::bind(writer, boost::cref(index), file.str())));
+	}
+	else
+	{
+		task.push_back(SyntenyFinder::TimedTask(prefix + extension, boost::bind(writer, boost::cref(index), prefix + extension)));
+	}
+}
+
+struct RunOptions
+{
+	SyntenyFinder::PipelineParameters pipeline;
+	std::set<std::string> output;
+	std::string outDir;
+	std::string tempDir;
+	bool inRAM;
+	bool gff;
+	bool hierarchy;
+	bool allStages;
+	bool graphFile;
+	bool verbose;
+	size_t threads;
+};
+
+struct JobStats
+{
+	size_t inputSize;
+	size_t blocks;
+	JobStats(): inputSize(0), blocks(0) {}
+};
+
+void ReportStage(size_t stage, SyntenyFinder::BlockFinder & finder, const RunOptions & options, size_t lastK)
+{
+	const std::vector<std::pair<int, int> > & stageList = options.pipeline.stage;
+	SyntenyFinder::BlockFinder::ProgressCallBack progress = options.verbose ? PutProgressChr : SyntenyFinder::BlockFinder::ProgressCallBack();
+	if(stage < stageList.size())
+	{
+		if(options.graphFile && (options.hierarchy || options.allStages))
+		{
+			SyntenyFinder::PhaseTimer timer("graph_output");
+			std::stringstream ss;
+			ss << options.outDir << "/de_bruijn_graph" << stage << ".dot";
+			std::ofstream graph(ss.str().c_str(), std::ios::out);
+			finder.SerializeCondensedGraph(stageList[stage].first, graph, progress);
+		}
+
+		if(options.verbose)
+		{
+			std::cout << "Simplification stage " << stage + 1 << " of " << stageList.size() << std::endl;
+			std::cout << "Enumerating vertices of the graph, then performing bulge removal..." << std::endl;
+		}
+	}
+	else
+	{
+		if(options.verbose)
+		{
+			std::cout << "Finding synteny blocks and generating the output..." << std::endl;
+		}
+
+		if(options.graphFile)
+		{
+			SyntenyFinder::PhaseTimer timer("graph_output");
+			std::stringstream ss;
+			ss << options.outDir << "/de_bruijn_graph";
+			if(options.allStages)
+			{
+				ss << stageList.size();
+			}
+
+			ss << ".dot";
+			std::ofstream graph(ss.str().c_str(), std::ios::out);
+			finder.SerializeCondensedGraph(lastK, graph, progress);
+		}
+	}
+}
+
+JobStats RunJob(const std::vector<std::string> & fileName, const RunOptions & options, SyntenyFinder::Workspace * workspace)
+{
+	SyntenyFinder::ResetRunStats();
+	if(options.pipeline.correctBoundaries && fileName.size() != 2)
+	{
+		throw std::runtime_error("In correction mode only two FASTA files are acceptable");
+	}
+
+	JobStats stats;
+	std::set<size_t> referenceChrId;
+	std::vector<SyntenyFinder::FASTARecord> chrList;
+	std::auto_ptr<SyntenyFinder::PhaseTimer> loadTimer(new SyntenyFinder::PhaseTimer("fasta_load"));
+	for(std::vector<std::string>::const_iterator it = fileName.begin(); it != fileName.end(); it++)
+	{
+		SyntenyFinder::FASTAReader reader(*it);
+		if(!reader.IsOk())
+		{
+			throw std::runtime_error(("Cannot open file " + *it).c_str());
+		}
+
+		reader.GetSequences(chrList);
+		if(it == fileName.begin())
+		{
+			for(size_t i = 0; i < chrList.size(); i++)
+			{
+				referenceChrId.insert(chrList[i].GetId());
+			}
+		}
+	}
+
+	for(size_t i = 0; i < chrList.size(); i++)
+	{
+		stats.inputSize += chrList[i].GetSequence().size();
+	}
+
+	if(stats.inputSize > SyntenyFinder::MAX_INPUT_SIZE)
+	{
+		throw std::runtime_error("Input is larger than 1 GB, can't proceed");
+	}
+
+	loadTimer.reset();
+	const std::vector<std::pair<int, int> > & stage = options.pipeline.stage;
+	size_t lastK = options.pipeline.lastK > 0 ? options.pipeline.lastK : std::min(stage.size() > 0 ? stage.back().first : INT_MAX, static_cast<int>(options.pipeline.minBlockSize));
+	SyntenyFinder::CreateOutDirectory(options.outDir);
+	SyntenyFinder::PipelineParameters pipeline = options.pipeline;
+	pipeline.lastK = lastK;
+	pipeline.allStages = options.hierarchy || options.allStages;
+	pipeline.tempDir = options.inRAM ? "" : (options.tempDir.empty() ? options.outDir : options.tempDir);
+	pipeline.referenceChrId = referenceChrId;
+	pipeline.workspace = workspace;
+	std::vector<std::vector<SyntenyFinder::BlockInstance> > history;
+	SyntenyFinder::FindSyntenyBlocks(chrList, pipeline, history, options.verbose ? PutProgressChr : SyntenyFinder::BlockFinder::ProgressCallBack(),
+		boost::bind(ReportStage, _1, _2, boost::cref(options), lastK));
+	stats.blocks = history.back().size();
+
+	bool oldFormat = !options.gff;
+	const std::set<std::string> & output = options.output;
+	SyntenyFinder::OutputGenerator generator(chrList);
+	CoordsWriter coordsWriter = 
+		oldFormat ? boost::bind(&SyntenyFinder::OutputGenerator::ListBlocksIndices, boost::cref(generator), _1, _2)
+				  : boost::bind(&SyntenyFinder::OutputGenerator::ListBlocksIndicesGFF, boost::cref(generator), _1, _2);
+	CoordsWriter binaryCoordsWriter = boost::bind(&SyntenyFinder::OutputGenerator::ListBlocksIndicesBinary, boost::cref(generator), _1, _2);
+	const std::string defaultCoordsPrefix = options.outDir + "/blocks_coords";
+	const std::string defaultPermutationsFile = options.outDir + "/genomes_permutations.txt";
+	const std::string defaultCoverageReportFile = options.outDir + "/coverage_report.txt";
+	const std::string defaultSequencesFile = options.outDir + "/blocks_sequences.fasta";		
+	const std::string defaultCircosDir = options.outDir + "/circos";
+	const std::string defaultCircosFile = defaultCircosDir + "/circos.conf";
+	const std::string defaultD3File = options.outDir + "/d3_blocks_diagram.html";
+
+	if(pipeline.findBlocks)
+	{
+		SyntenyFinder::PhaseTimer outputTimer("output");
+
+		using SyntenyFinder::TimedTask;
+		std::vector<TimedTask> writer;
+		SyntenyFinder::BlockIndex index(history.back(), chrList.size());
+		if(output.count("coords"))
+		{
+			AddCoordsWriters(writer, coordsWriter, history, index, options.allStages, defaultCoordsPrefix, oldFormat ? ".txt" : ".gff");
+		}
+
+		if(output.count("bincoords"))
+		{
+			AddCoordsWriters(writer, binaryCoordsWriter, history, index, options.allStages, defaultCoordsPrefix, ".bin");
+		}
+
+		if(output.count("permutations"))
+		{
+			writer.push_back(TimedTask(defaultPermutationsFile, boost::bind(&SyntenyFinder::OutputGenerator::ListChromosomesAsPermutations, boost::cref(generator), boost::cref(index), defaultPermutationsFile)));
+		}
+
+		if(output.count("coverage"))
+		{
+			writer.push_back(TimedTask(defaultCoverageReportFile, boost::bind(&SyntenyFinder::OutputGenerator::GenerateReport, boost::cref(generator), boost::cref(index), defaultCoverageReportFile)));
+		}
+
+		if(output.count("sequences"))
+		{
+			writer.push_back(TimedTask(defaultSequencesFile, boost::bind(&SyntenyFinder::OutputGenerator::ListBlocksSequences, boost::cref(generator), boost::cref(index), defaultSequencesFile)));
+		}
+
+		if(output.count("d3"))
+		{
+			writer.push_back(TimedTask(defaultD3File, boost::bind(&SyntenyFinder::OutputGenerator::GenerateD3Output, boost::cref(generator), boost::cref(index), defaultD3File)));
+		}
+
+		if(output.count("circos") && !options.hierarchy)
+		{
+			writer.push_back(TimedTask(defaultCircosFile, boost::bind(&SyntenyFinder::OutputGenerator::GenerateCircosOutput, boost::cref(generator), boost::cref(index), defaultCircosFile, defaultCircosDir)));
+		}
+		else if(output.count("circos"))
+		{
+			writer.push_back(TimedTask(defaultCircosFile, boost::bind(&SyntenyFinder::OutputGenerator::GenerateHierarchyCircosOutput, boost::cref(generator), boost::cref(history), defaultCircosFile, defaultCircosDir)));
+		}
+
+		SyntenyFinder::RunTasksConcurrently(writer);
+		std::stringstream log;
+		log.setf(log.fixed);
+		log.precision(2);
+		for(std::vector<TimedTask>::const_iterator it = writer.begin(); it != writer.end(); ++it)
+		{
+			log << "Output " << it->name << " written in " << it->elapsed << " seconds" << std::endl;
+			SyntenyFinder::RecordPhaseWallTime(it->name.substr(options.outDir.size() + 1), it->elapsed);
+		}
+
+		if(options.verbose)
+		{
+			std::cout << log.str();
+		}
+	}
+
+	SyntenyFinder::WriteRunStats(options.outDir + "/run_stats.json", options.threads);
+	if(options.verbose)
+	{
+		std::cout.setf(std::cout.fixed);
+		std::cout.precision(2);
+		std::cout << "Time elapsed: " << SyntenyFinder::GetRunWallTime() << " seconds" << std::endl;
+	}
+
+	return stats;
+}
+
+struct BatchJob
+{
+	size_t line;
+	std::vector<std::string> fileName;
+	RunOptions options;
+	JobStats stats;
+	std::string error;
+	bool done;
+	BatchJob(): line(0), done(false) {}
+};
+
+//Each line of the manifest is: output directory, parameters set ("loose", "fine",
+//"far" or name of a stage file) and FASTA files, separated by tabs. Empty lines and lines starting with '#' are skipped.
+std::vector<BatchJob> ReadBatchFile(const std::string & fileName,
+									const RunOptions & defaults,
+									const std::map<std::string, std::vector<std::pair<int, int> > > & defaultParameters)
+{
+	std::ifstream in(fileName.c_str());
+	if(!in)
+	{
+		throw std::runtime_error(("Cannot open file " + fileName).c_str());
+	}
+
+	std::string buffer;
+	std::vector<BatchJob> ret;
+	for(size_t line = 1; std::getline(in, buffer); line++)
+	{
+		if(!buffer.empty() && buffer[buffer.size() - 1] == '\r')
+		{
+			buffer.erase(buffer.size() - 1);
+		}
+
+		if(buffer.empty() || buffer[0] == '#')
+		{
+			continue;
+		}
+
+		std::string field;
+		std::vector<std::string> column;
+		std::stringstream ss(buffer);
+		while(std::getline(ss, field, '\t'))
+		{
+			column.push_back(field);
+		}
+
+		if(column.size() < 3)
+		{
+			std::stringstream error;
+			error << "line " << line << " of " << fileName << " must contain output directory, parameters and FASTA files";
+			throw std::runtime_error(error.str());
+		}
+
+		BatchJob job;
+		job.line = line;
+		job.options = defaults;
+		job.options.verbose = false;
+		job.options.outDir = column[0];
+		job.fileName.assign(column.begin() + 2, column.end());
+		std::map<std::string, std::vector<std::pair<int, int> > >::const_iterator preset = defaultParameters.find(column[1]);
+		if(preset != defaultParameters.end())
+		{
+			job.options.pipeline.stage = preset->second;
+		}
+		else
+		{
+			job.options.pipeline.stage = ReadStageFile(column[1]);
+		}
+
+		ret.push_back(job);
+	}
+
+	return ret;
+}
+
+void RunBatchJob(BatchJob & job, const std::vector<boost::shared_ptr<SyntenyFinder::Workspace> > & workspace)
+{
+	try
+	{
+		job.stats = RunJob(job.fileName, job.options, workspace[SyntenyFinder::GetThreadId()].get());
+		job.done = true;
+	}
+	catch(std::exception & e)
+	{
+		job.error = e.what();
+	}
+	catch(...)
+	{
+		job.error = "unknown error";
+	}
+}
+
+//Runs the jobs on the workers, each worker reuses its buffers between the jobs.
+//Returns the number of failed jobs
+size_t RunBatch(std::vector<BatchJob> & job, const std::string & reportFile)
+{
+	using SyntenyFinder::TimedTask;
+	SyntenyFinder::SetNestedParallelism(false);
+	double start = SyntenyFinder::GetWallClockTime();
+	std::vector<boost::shared_ptr<SyntenyFinder::Workspace> > workspace(SyntenyFinder::GetThreadsNumber());
+	for(size_t i = 0; i < workspace.size(); i++)
+	{
+		workspace[i].reset(new SyntenyFinder::Workspace());
+	}
+
+	std::vector<TimedTask> task;
+	for(size_t i = 0; i < job.size(); i++)
+	{
+		task.push_back(TimedTask(job[i].options.outDir, boost::bind(RunBatchJob, boost::ref(job[i]), boost::cref(workspace))));
+	}
+
+	SyntenyFinder::RunTasksConcurrently(task);
+	std::ofstream report(reportFile.c_str());
+	if(!report)
+	{
+		throw std::runtime_error(("Cannot open file " + reportFile).c_str());
+	}
+
+	size_t failed = 0;
+	report.setf(report.fixed);
+	report.precision(2);
+	report << "Line\tOutput\tStatus\tInput_size\tBlocks\tWall_time\tError" << std::endl;
+	for(size_t i = 0; i < job.size(); i++)
+	{
+		failed += job[i].done ? 0 : 1;
+		report << job[i].line << '\t' << job[i].options.outDir << '\t' << (job[i].done ? "ok" : "failed") << '\t';
+		report << job[i].stats.inputSize << '\t' << job[i].stats.blocks << '\t' << task[i].elapsed << '\t' << job[i].error << std::endl;
+		if(!job[i].done)
+		{
+			std::cerr << "error: job on line " << job[i].line << ": " << job[i].error << std::endl;
+		}
+	}
+
+	double elapsed = SyntenyFinder::GetWallClockTime() - start;
+	std::cout.setf(std::cout.fixed);
+	std::cout.precision(2);
+	std::cout << job.size() << " jobs finished, " << failed << " failed, " << SyntenyFinder::GetThreadsNumber() << " workers" << std::endl;
+	std::cout << "Time elapsed: " << elapsed << " seconds";
+	if(elapsed > 0)
+	{
+		std::cout << ", " << job.size() / elapsed << " jobs per second";
+	}
+
+	std::cout << std::endl << "Report is written to " << reportFile << std::endl;
+	return failed;
+}
+
+std::set<std::string> ParseOutputs(const std::string & list, const std::vector<std::string> & allowed)
+{
+	std::string name;
+	std::set<std::string> ret;
+	std::stringstream ss(list);
+	while(std::getline(ss, name, ','))
+	{
+		if(name == "all")
+		{
+			ret.insert(allowed.begin(), allowed.end());
+		}
+		else if(std::find(allowed.begin(), allowed.end(), name) != allowed.end())
+		{
+			ret.insert(name);
+		}
+		else if(!name.empty())
+		{
+			throw std::runtime_error(("Unknown output \"" + name + "\"").c_str());
+		}
+	}
+
+	return ret;
+}
+
 int main(int argc, char * argv[])
 {
 	signal(SIGINT, SignalHandler);
@@ -53,6 +466,8 @@ int main(int argc, char * argv[])
 	defaultParameters["loose"] = LooseStageFile();
 	defaultParameters["fine"] = FineStageFile();
 	defaultParameters["far"] = FarStageFile();
+	const std::string outputNameArray[] = {"coords", "bincoords", "permutations", "coverage", "sequences", "d3", "circos"};
+	std::vector<std::string> outputName(outputNameArray, outputNameArray + sizeof(outputNameArray) / sizeof(outputNameArray[0]));
 	GreaterIntegerConstraint greaterThanOne(1);
 	GreaterIntegerConstraint greaterThanZero(0);
 	try
@@ -66,6 +481,15 @@ int main(int argc, char * argv[])
 			&greaterThanZero,
 			cmd);
 
+		TCLAP::ValueArg<unsigned int> maxMultiplicity("",
+			"maxmultiplicity",
+			"Do not remove bulges around the vertices that occur more times than this value, "
+			"their number is reported in run_stats.json. Default = 0 (no limit).",
+			false,
+			0,
+			"integer",
+			cmd);
+
 		TCLAP::SwitchArg correctBoundariesFlag("",
 			"correctboundaries",
 			"Correct boundaries of unique synteny blocks.",
@@ -161,6 +585,22 @@ int main(int argc, char * argv[])
 			cmd,
 			false);
 
+		TCLAP::ValueArg<unsigned int> bloomK("",
+			"bloomk",
+			"Use Bloom filter instead of suffix array for finding vertices of the graphs with K not less than this value. "
+			"Needs less memory for large K, default = 0 (never).",
+			false,
+			0,
+			"integer",
+			cmd);
+
+		TCLAP::SwitchArg fmIndex("",
+			"fmindex",
+			"Use FM-index of the positive strand instead of suffix array for finding vertices of the graphs. "
+			"Needs about half of the memory, all computations are in RAM.",
+			cmd,
+			false);
+
 		TCLAP::SwitchArg noBlocks("",
 			"noblocks",
 			"Do not compute synteny blocks",
@@ -169,10 +609,33 @@ int main(int argc, char * argv[])
 
 		TCLAP::UnlabeledMultiArg<std::string> fileName("filenames",
 			"FASTA file(s) with nucleotide sequences.",
-			true,
+			false,
 			"fasta files with genomes",
 			cmd);
 
+		TCLAP::ValueArg<std::string> outputs("",
+			"outputs",
+			"Comma separated list of output files to generate: coords, bincoords, permutations, coverage, sequences, d3, circos or all. "
+			"By default all of them are generated except sequences.",
+			false,
+			"",
+			"list",
+			cmd);
+
+		TCLAP::SwitchArg noD3("",
+			"no-d3",
+			"Do not generate the html-diagram of synteny blocks.",
+			cmd,
+			false);
+
+		TCLAP::ValueArg<int> threads("",
+			"threads",
+			"Number of threads used for writing the output files.",
+			false,
+			static_cast<int>(SyntenyFinder::GetThreadsNumber()),
+			&greaterThanZero,
+			cmd);
+
 		TCLAP::ValueArg<std::string> outFileDir("o",
 			"outdir",
 			"Directory where output files are written",
@@ -181,172 +644,79 @@ int main(int argc, char * argv[])
 			"dir name",
 			cmd);		
 
-		cmd.xorAdd(parameters, stageFile);
+		TCLAP::ValueArg<std::string> batchFile("",
+			"batch",
+			"Tab separated file with jobs: output directory, parameters set or stage file and FASTA files. See USAGE file for more information.",
+			false,
+			"",
+			"file name");
+
+		std::vector<TCLAP::Arg*> stageSource;
+		stageSource.push_back(&parameters);
+		stageSource.push_back(&stageFile);
+		stageSource.push_back(&batchFile);
+		cmd.xorAdd(stageSource);
 		cmd.parse(argc, argv);
-		std::vector<std::pair<int, int> > stage;
-		if(parameters.isSet())
-		{
-			stage = defaultParameters[parameters.getValue()];
-		}
-		else
+		SyntenyFinder::SetThreadsNumber(threads.getValue());
+		std::set<std::string> output = ParseOutputs(outputs.isSet() ? outputs.getValue() : "coords,bincoords,permutations,coverage,d3,circos", outputName);
+		if(sequencesFile.isSet())
 		{
-			stage = ReadStageFile(stageFile.getValue());
-		}
-		
-		int trimK = INT_MAX;
-		size_t totalSize = 0;
-		std::set<size_t> referenceChrId;
-		bool allStages = allStagesFlag.isSet();		
-		bool hierarchy = hierarchyPicture.isSet();
-		bool noPostProcessing = noPostProcessingFlag.isSet();
-		bool correctBoundaries = correctBoundariesFlag.isSet();
-		if(correctBoundaries && (fileName.end() - fileName.begin()) != 2)
-		{
-			throw std::runtime_error("In correction mode only two FASTA files are acceptable");
+			output.insert("sequences");
 		}
 
-		std::vector<SyntenyFinder::FASTARecord> chrList;
-		for(std::vector<std::string>::const_iterator it = fileName.begin(); it != fileName.end(); it++)
+		if(noD3.isSet())
 		{
-			SyntenyFinder::FASTAReader reader(*it);
-			if(!reader.IsOk())
-			{
-				throw std::runtime_error(("Cannot open file " + *it).c_str());
-			}
-
-			reader.GetSequences(chrList);
-			if(it == fileName.begin())
-			{
-				for(size_t i = 0; i < chrList.size(); i++)
-				{
-					referenceChrId.insert(chrList[i].GetId());
-				}
-			}
+			output.erase("d3");
 		}
-		
-		for(size_t i = 0; i < chrList.size(); i++)
+
+		RunOptions options;
+		if(parameters.isSet())
 		{
-			totalSize += chrList[i].GetSequence().size();
+			options.pipeline.stage = defaultParameters[parameters.getValue()];
 		}
-
-		if(totalSize > SyntenyFinder::MAX_INPUT_SIZE)
+		else if(stageFile.isSet())
 		{
-			throw std::runtime_error("Input is larger than 1 GB, can't proceed");
+			options.pipeline.stage = ReadStageFile(stageFile.getValue());
 		}
-		
-		std::vector<std::vector<SyntenyFinder::BlockInstance> > history(stage.size() + 1);
-		std::string tempDir = tempFileDir.isSet() ? tempFileDir.getValue() : outFileDir.getValue();		
-		std::auto_ptr<SyntenyFinder::BlockFinder> finder(inRAM.isSet() ? new SyntenyFinder::BlockFinder(chrList) : new SyntenyFinder::BlockFinder(chrList, tempDir));
-		SyntenyFinder::Postprocessor processor(chrList, minBlockSize.getValue());
 
-		for(size_t i = 0; i < stage.size(); i++)
+		options.pipeline.minBlockSize = minBlockSize.getValue();
+		options.pipeline.maxIterations = maxIterations.getValue();
+		options.pipeline.maxMultiplicity = maxMultiplicity.getValue();
+		options.pipeline.lastK = lastKValue.isSet() ? lastKValue.getValue() : 0;
+		options.pipeline.sharedOnly = sharedOnly.getValue();
+		options.pipeline.postProcessing = !noPostProcessingFlag.isSet();
+		options.pipeline.correctBoundaries = correctBoundariesFlag.isSet();
+		options.pipeline.findBlocks = !noBlocks.isSet();
+		options.pipeline.bloomK = bloomK.getValue();
+		options.pipeline.fmIndex = fmIndex.isSet();
+		options.output = output;
+		options.outDir = outFileDir.getValue();
+		options.tempDir = tempFileDir.isSet() ? tempFileDir.getValue() : "";
+		options.inRAM = inRAM.isSet();
+		options.gff = GFFFormatFlag.isSet();
+		options.hierarchy = hierarchyPicture.isSet();
+		options.allStages = allStagesFlag.isSet();
+		options.graphFile = graphFile.isSet();
+		options.verbose = true;
+		options.threads = threads.getValue();
+		if(batchFile.isSet())
 		{
-			trimK = std::min(trimK, stage[i].first);
-			if(hierarchy || allStages)
-			{
-				if(!noBlocks.isSet())
-				{
-					finder->GenerateSyntenyBlocks(stage[i].first, trimK, stage[i].first, history[i], sharedOnly.getValue());
-					if(!noPostProcessing)
-					{
-						processor.GlueStripes(history[i]);
-					}
-				}
-
-				if(graphFile.isSet())
-				{
-					std::stringstream ss;
-					ss << outFileDir.getValue() << "/de_bruijn_graph" << i << ".dot";
-					std::ofstream graph(ss.str().c_str(), std::ios::out);
-					finder->SerializeCondensedGraph(stage[i].first, graph, PutProgressChr);
-				}
-			}
-
-			std::cout << "Simplification stage " << i + 1 << " of " << stage.size() << std::endl;
-			std::cout << "Enumerating vertices of the graph, then performing bulge removal..." << std::endl;
-			finder->PerformGraphSimplifications(stage[i].first, stage[i].second, maxIterations.getValue(), PutProgressChr);			
-		}
-
-		std::cout << "Finding synteny blocks and generating the output..." << std::endl;
-		trimK = std::min(trimK, static_cast<int>(minBlockSize.getValue()));
-		size_t lastK = lastKValue.isSet() ? lastKValue.getValue() : std::min(stage.size() > 0 ? stage.back().first : INT_MAX, static_cast<int>(minBlockSize.getValue()));
-		bool oldFormat = !GFFFormatFlag.isSet();
-		SyntenyFinder::OutputGenerator generator(chrList);
-		SyntenyFinder::CreateOutDirectory(outFileDir.getValue());
-		boost::function<void(const std::vector<SyntenyFinder::BlockInstance>&, const std::string&)> coordsWriter = 
-			oldFormat ? boost::bind(&SyntenyFinder::OutputGenerator::ListBlocksIndices, boost::cref(generator), _1, _2)
-					  : boost::bind(&SyntenyFinder::OutputGenerator::ListBlocksIndicesGFF, boost::cref(generator), _1, _2);
-		const std::string defaultCoordsFile = outFileDir.getValue() + "/blocks_coords" + (oldFormat ? ".txt" : ".gff");
-		const std::string defaultPermutationsFile = outFileDir.getValue() + "/genomes_permutations.txt";
-		const std::string defaultCoverageReportFile = outFileDir.getValue() + "/coverage_report.txt";
-		const std::string defaultSequencesFile = outFileDir.getValue() + "/blocks_sequences.fasta";		
-		const std::string defaultCircosDir = outFileDir.getValue() + "/circos";
-		const std::string defaultCircosFile = defaultCircosDir + "/circos.conf";
-		const std::string defaultD3File = outFileDir.getValue() + "/d3_blocks_diagram.html";
-
-		if(!noBlocks.isSet())
-		{
-			finder->GenerateSyntenyBlocks(lastK, trimK, minBlockSize.getValue(), history.back(), sharedOnly.getValue(), PutProgressChr);
-			if(!noPostProcessing)
-			{
-				processor.GlueStripes(history.back());
-			}
-
-			if(correctBoundaries)
-			{			
-				processor.ImproveBlockBoundaries(history.back(), referenceChrId);
-			}
-
-			if(allStages)
-			{			
-				for(size_t i = 0; i < history.size(); i++)
-				{
-					std::stringstream file;
-					file << outFileDir.getValue() << "/blocks_coords" << i << (oldFormat ? ".txt" : ".gff");
-					coordsWriter(history[i], file.str());
-				}
-			}
-			else
-			{
-				coordsWriter(history.back(), defaultCoordsFile);
-			}
-
-			generator.ListChromosomesAsPermutations(history.back(), defaultPermutationsFile);
-			generator.GenerateReport(history.back(), defaultCoverageReportFile);				
-			if(sequencesFile.isSet())
+			if(fileName.isSet())
 			{
-				generator.ListBlocksSequences(history.back(), defaultSequencesFile);
+				throw std::runtime_error("FASTA files can't be specified together with --batch");
 			}
 
-			generator.GenerateD3Output(history.back(), defaultD3File);
-			if(!hierarchy)
-			{
-				generator.GenerateCircosOutput(history.back(), defaultCircosFile, defaultCircosDir);
-			}
-			else
-			{
-				generator.GenerateHierarchyCircosOutput(history, defaultCircosFile, defaultCircosDir);
-			}
+			std::vector<BatchJob> job = ReadBatchFile(batchFile.getValue(), options, defaultParameters);
+			SyntenyFinder::CreateOutDirectory(options.outDir);
+			return RunBatch(job, options.outDir + "/batch_report.tsv") == 0 ? 0 : 1;
 		}
 
-		if(graphFile.isSet())
+		if(!fileName.isSet())
 		{
-			std::stringstream ss;
-			ss << outFileDir.getValue() << "/de_bruijn_graph";
-			if(allStages)
-			{			
-				ss << stage.size();
-			}
-
-			ss << ".dot";						
-			std::ofstream graph(ss.str().c_str(), std::ios::out);
-			finder->SerializeCondensedGraph(lastK, graph, PutProgressChr);
-			
+			throw std::runtime_error("no FASTA files are specified");
 		}
 
-		std::cout.setf(std::cout.fixed);
-		std::cout.precision(2);
-	//	std::cout << "Time elapsed: " << double(clock()) / CLOCKS_PER_SEC << " seconds" << std::endl;
+		RunJob(fileName.getValue(), options, 0);
 	} 
 	catch (TCLAP::ArgException &e)
 	{
@@ -15,6 +15,7 @@ namespace SyntenyFinder
 	}
 
 	const Size DNASequence::StrandIterator::INFO_BITS = 2;
+	const Size DNASequence::StrandIterator::MARK_BIT = 2;
 	
 	Size DNASequence::StrandIterator::PositionMask()
 	{
@@ -193,10 +194,10 @@ namespace SyntenyFinder
 	{
 		if(direction_ == positive)
 		{
-			return StrandIterator(AdvanceBackward(it_, 1), negative);
+			return StrandIterator(SyntenyFinder::AdvanceBackward(it_, 1), negative);
 		}
 
-		return StrandIterator(AdvanceForward(it_, 1), positive);
+		return StrandIterator(SyntenyFinder::AdvanceForward(it_, 1), positive);
 	}
 
 	char DNASequence::StrandIterator::operator * () const
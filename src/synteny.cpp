@@ -7,6 +7,7 @@
 #pragma GCC diagnostic ignored "-Wc++11-extensions"
 
 #include "blockfinder.h"
+#include "runstats.h"
 
 namespace SyntenyFinder
 {
@@ -30,6 +31,7 @@ namespace SyntenyFinder
 
 	bool BlockFinder::TrimBlocks(std::vector<Edge> & block, size_t trimK, size_t minSize)
 	{	
+		PhaseTimer timer("trimming");
 		size_t pos = 0;
 		bool drop = false;		
 		std::vector<std::string> blockSeq(block.size());		
@@ -41,10 +43,9 @@ namespace SyntenyFinder
 		
 		const size_t oo = UINT_MAX;
 		IteratorProxyVector startKMer;
-		IndexedSequence iseq(blockSeq, trimK, "");
+		IndexedSequence iseq(blockSeq, trimK, "", workspace_);
 		DNASequence & sequence = iseq.Sequence();
 		BifurcationStorage & bifStorage = iseq.BifStorage();		
-		iseq.ConstructChrIndex();
 		std::vector<Edge> ret;
 		for(size_t chr = 0; chr < block.size(); chr++)
 		{
@@ -121,7 +122,7 @@ namespace SyntenyFinder
 		return drop;
 	}
 
-	void BlockFinder::ResolveOverlap(EdgeIterator start, EdgeIterator end, size_t minSize, std::vector<Indicator> & overlap, std::vector<Edge> & nowBlock) const
+	void BlockFinder::ResolveOverlap(const EdgeTable & edge, EdgeIterator start, EdgeIterator end, size_t minSize, std::vector<Indicator> & overlap, std::vector<Edge> & nowBlock) const
 	{
 		nowBlock.clear();		
 		std::set<ChrPos> localOverlap;
@@ -130,9 +131,10 @@ namespace SyntenyFinder
 			size_t segEnd = 0;
 			size_t bestStart = 0;
 			size_t bestEnd = 0;			
-			size_t chrNumber = start->GetChr();
-			size_t end = start->GetOriginalPosition() + start->GetOriginalLength();
-			for(size_t segStart = start->GetOriginalPosition(); segStart < end; segStart = segEnd)
+			Edge now = edge[*start];
+			size_t chrNumber = now.GetChr();
+			size_t end = now.GetOriginalPosition() + now.GetOriginalLength();
+			for(size_t segStart = now.GetOriginalPosition(); segStart < end; segStart = segEnd)
 			{
 				for(segEnd = segStart; segEnd < end && overlap[chrNumber][segEnd] == POS_FREE; segEnd++)
 				{
@@ -154,8 +156,8 @@ namespace SyntenyFinder
 
 			if(bestEnd - bestStart >= minSize)
 			{
-				nowBlock.push_back(Edge(start->GetChr(), start->GetDirection(), start->GetStartVertex(), start->GetEndVertex(),
-					start->GetActualPosition(), start->GetActualLength(), bestStart, bestEnd - bestStart, start->GetFirstChar()));
+				nowBlock.push_back(Edge(now.GetChr(), now.GetDirection(), now.GetStartVertex(), now.GetEndVertex(),
+					now.GetActualPosition(), now.GetActualLength(), bestStart, bestEnd - bestStart, now.GetFirstChar()));
 				for(size_t pos = bestStart; pos < bestEnd; pos++)
 				{
 					ChrPos now(chrNumber, pos);
@@ -228,7 +230,7 @@ namespace SyntenyFinder
 	
 	void BlockFinder::GenerateSyntenyBlocks(size_t k, size_t trimK, size_t minSize, std::vector<BlockInstance> & block, bool sharedOnly, ProgressCallBack enumeration)
 	{
-		std::vector<Edge> edge;
+		EdgeTable edge;
 		std::vector<Indicator> overlap(rawSeq_.size());
 		for(size_t i = 0; i < rawSeq_.size(); i++)
 		{
@@ -236,30 +238,34 @@ namespace SyntenyFinder
 		}
 
 		{
-			IndexedSequence iseq(rawSeq_, originalPos_, k, tempDir_);
-			ListEdges(iseq.Sequence(), iseq.BifStorage(), k, edge);			
+			IndexedSequence iseq(rawSeq_, originalPos_, k, tempDir_, false, workspace_, GetEnumeration(k));
+			PhaseTimer timer("list_edges");
+			ListEdges(iseq.Sequence(), iseq.BifStorage(), k, minSize, edge);			
 		}
 		
 		block.clear();
 		int blockCount = 1;
-		edge.erase(std::remove_if(edge.begin(), edge.end(), boost::bind(EdgeEmpty, _1, minSize)), edge.end());
+		//The edges are sorted by their indices, the order of the ties is the same
+		//as if the edges were sorted themselves
+		std::vector<Size> order(edge.Size());
+		std::generate(order.begin(), order.end(), Counter<Size>());
 		std::vector<std::pair<size_t, size_t> > group;
-		GroupBy(edge, CompareEdgesNaturally, std::back_inserter(group));
+		GroupBy(order, EdgeTable::NaturalOrder(&edge), std::back_inserter(group));
 		EdgeGroupComparer groupComparer(&edge);
 		std::sort(group.begin(), group.end(), groupComparer);
 		for(size_t g = 0; g < group.size(); g++)
 		{
-			std::vector<Edge>::iterator firstEdge = edge.begin() + group[g].first;
-			std::vector<Edge>::iterator lastEdge = edge.begin() + group[g].second;			 
-			std::sort(firstEdge, lastEdge, CompareEdgesByDirection);
-			if(lastEdge - firstEdge < 2 || std::find_if(firstEdge, lastEdge, Edge::PositiveEdge) == lastEdge)
+			std::vector<Size>::iterator firstEdge = order.begin() + group[g].first;
+			std::vector<Size>::iterator lastEdge = order.begin() + group[g].second;			 
+			std::sort(firstEdge, lastEdge, EdgeTable::DirectionOrder(&edge));
+			if(lastEdge - firstEdge < 2 || edge.GetDirection(*firstEdge) != DNASequence::positive)
 			{
 				continue;
 			}
 			
 			std::vector<Edge> nowBlock;
 			std::vector<size_t> occur(rawSeq_.size(), 0);
-			ResolveOverlap(firstEdge, lastEdge, minSize, overlap, nowBlock);			
+			ResolveOverlap(edge, firstEdge, lastEdge, minSize, overlap, nowBlock);			
 			while(TrimBlocks(nowBlock, trimK, minSize));
 			for(size_t nowEdge = 0; nowEdge < nowBlock.size(); nowEdge++)
 			{
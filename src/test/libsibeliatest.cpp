@@ -0,0 +1,114 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#include "syntheticgenome.h"
+#include "../libsibelia.h"
+
+namespace
+{
+	const size_t JOBS_NUMBER = 4;
+
+	struct Job
+	{
+		std::vector<SyntenyFinder::FASTARecord> chrList;
+		std::vector<std::vector<int> > result;
+		std::string error;
+	};
+
+	bool RunJob(Job & job, const char * tempDir)
+	{
+		std::vector<const char*> sequence;
+		std::vector<size_t> length;
+		for(size_t i = 0; i < job.chrList.size(); i++)
+		{
+			sequence.push_back(job.chrList[i].GetSequence().data());
+			length.push_back(job.chrList[i].GetSequence().size());
+		}
+
+		char error[256];
+		sibelia_block * block;
+		size_t blockNumber;
+		sibelia_parameters parameters;
+		sibelia_default_parameters(&parameters);
+		parameters.temp_dir = tempDir;
+		if(sibelia_find_blocks(&sequence[0], &length[0], sequence.size(), &parameters, &block, &blockNumber, error, sizeof(error)) != 0)
+		{
+			job.error = error;
+			return false;
+		}
+
+		job.result.clear();
+		for(size_t i = 0; i < blockNumber; i++)
+		{
+			int record[] = {block[i].signed_block_id, static_cast<int>(block[i].sequence), static_cast<int>(block[i].start), static_cast<int>(block[i].end)};
+			job.result.push_back(std::vector<int>(record, record + 4));
+		}
+
+		sibelia_free_blocks(block);
+		return true;
+	}
+}
+
+//Runs the same comparisons one by one and concurrently, the results must coincide
+int main()
+{
+	std::vector<Job> job(JOBS_NUMBER);
+	std::vector<std::vector<std::vector<int> > > expected(JOBS_NUMBER);
+	for(size_t i = 0; i < JOBS_NUMBER; i++)
+	{
+		SyntenyFinder::SyntheticGenomeParameters parameters;
+		std::vector<SyntenyFinder::TruthInstance> truth;
+		parameters.genomes = 2;
+		parameters.genomeSize = 50000;
+		parameters.segments = 5;
+		parameters.seed = i + 1;
+		SyntenyFinder::GenerateSyntheticGenomes(parameters, job[i].chrList, truth);
+		if(!RunJob(job[i], 0))
+		{
+			std::cerr << "error: " << job[i].error << std::endl;
+			return 1;
+		}
+
+		if(job[i].result.empty())
+		{
+			std::cerr << "error: no blocks found in job " << i << std::endl;
+			return 1;
+		}
+
+		expected[i].swap(job[i].result);
+	}
+
+	int failed = 0;
+	#pragma omp parallel for num_threads(JOBS_NUMBER) schedule(dynamic, 1) reduction(+:failed)
+	for(int i = 0; i < static_cast<int>(JOBS_NUMBER); i++)
+	{
+		if(!RunJob(job[i], i % 2 == 0 ? 0 : ".") || job[i].result != expected[i])
+		{
+			failed++;
+		}
+	}
+
+	if(failed > 0)
+	{
+		std::cerr << "error: " << failed << " concurrent jobs differ from the sequential ones" << std::endl;
+		return 1;
+	}
+
+	const char * invalid[] = {"ACGTZ"};
+	size_t invalidLength[] = {5};
+	char error[256];
+	sibelia_block * block;
+	size_t blockNumber;
+	sibelia_parameters parameters;
+	sibelia_default_parameters(&parameters);
+	if(sibelia_find_blocks(invalid, invalidLength, 1, &parameters, &block, &blockNumber, error, sizeof(error)) == 0)
+	{
+		std::cerr << "error: an illegal character is not reported" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
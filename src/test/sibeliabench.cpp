@@ -0,0 +1,208 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#include <tclap/CmdLine.h>
+#include "syntheticgenome.h"
+#include "../pipeline.h"
+#include "../util.h"
+#include "../runstats.h"
+
+//Every heap allocation of the benchmark goes through here, so allocations made
+//on the hot paths of the pipeline show up as the "hot_path_allocation" counter
+void * operator new(size_t size)
+{
+	SyntenyFinder::CountHeapAllocation();
+	void * ret = malloc(size == 0 ? 1 : size);
+	if(ret == 0)
+	{
+		throw std::bad_alloc();
+	}
+
+	return ret;
+}
+
+void * operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void * p) throw()
+{
+	free(p);
+}
+
+void operator delete[](void * p) throw()
+{
+	free(p);
+}
+
+//Generates a synthetic genome collection, runs the whole pipeline on it and
+//reports throughput of each phase, peak memory usage and accuracy of the blocks
+int main(int argc, char * argv[])
+{
+	signal(SIGINT, SignalHandler);
+	signal(SIGABRT, SignalHandler);
+	signal(SIGTERM, SignalHandler);
+	const std::string parameterSetNameArray[] = {"loose", "fine", "far"};
+	std::vector<std::string> parameterSetName(parameterSetNameArray, parameterSetNameArray + sizeof(parameterSetNameArray) / sizeof(parameterSetNameArray[0]));
+	std::map<std::string, std::vector<std::pair<int, int> > > defaultParameters;
+	defaultParameters["loose"] = LooseStageFile();
+	defaultParameters["fine"] = FineStageFile();
+	defaultParameters["far"] = FarStageFile();
+	try
+	{
+		SyntenyFinder::SyntheticGenomeParameters synthetic;
+		TCLAP::CmdLine cmd("Benchmark of Sibelia on synthetic genomes", ' ', VERSION);
+		TCLAP::ValueArg<size_t> genomes("", "genomes", "Number of genomes, default = 3.", false, synthetic.genomes, "integer", cmd);
+		TCLAP::ValueArg<size_t> genomeSize("", "size", "Approximate size of each genome in BP, default = 1000000.", false, synthetic.genomeSize, "integer", cmd);
+		TCLAP::ValueArg<size_t> chromosomes("", "chromosomes", "Number of chromosomes (contigs) in each genome, default = 1.", false, synthetic.chromosomes, "integer", cmd);
+		TCLAP::ValueArg<size_t> segments("", "segments", "Number of segments of the ancestral genome, default = 20.", false, synthetic.segments, "integer", cmd);
+		TCLAP::ValueArg<size_t> rearrangements("", "rearrangements", "Number of inversions and translocations in each genome, default = 4.", false, synthetic.rearrangements, "integer", cmd);
+		TCLAP::ValueArg<size_t> repeats("", "repeats", "Number of duplicated segments in each genome, default = 1.", false, synthetic.repeats, "integer", cmd);
+		TCLAP::ValueArg<double> divergence("", "divergence", "Rate of substitutions, indels occur 10 times less often, default = 0.01.", false, synthetic.divergence, "float", cmd);
+		TCLAP::ValueArg<uint64_t> seed("", "seed", "Seed of the random generator, default = 1.", false, synthetic.seed, "integer", cmd);
+		TCLAP::ValuesConstraint<std::string> allowedParametersVals(parameterSetName);
+		TCLAP::ValueArg<std::string> parameters("s", "parameters", "Parameters set, used for the simplification.", false, parameterSetName[0], &allowedParametersVals, cmd);
+		TCLAP::ValueArg<unsigned int> minBlockSize("m", "minblocksize", "Minimum size of a synteny block, default value = 5000 BP.", false, 5000, "integer", cmd);
+		TCLAP::ValueArg<int> maxIterations("i", "maxiterations", "Maximum number of iterations during a stage of simplification, default = 4.", false, 4, "integer", cmd);
+		TCLAP::SwitchArg inRAM("r", "inram", "Perform all computations in RAM, don't create temp files.", cmd, false);
+		TCLAP::ValueArg<unsigned int> bloomK("", "bloomk", "Use Bloom filter for finding vertices of the graphs with K not less than this value, default = 0 (never).", false, 0, "integer", cmd);
+		TCLAP::SwitchArg fmIndex("", "fmindex", "Use FM-index of the positive strand for finding vertices of the graphs.", cmd, false);
+		TCLAP::SwitchArg keepInput("", "keepinput", "Write the generated genomes and the true blocks to the output directory.", cmd, false);
+		TCLAP::ValueArg<double> minRecall("", "minrecall", "Fail if the recall of the blocks is lower, default = 0.", false, 0, "float", cmd);
+		TCLAP::ValueArg<double> minPrecision("", "minprecision", "Fail if the precision of the blocks is lower, default = 0.", false, 0, "float", cmd);
+		TCLAP::ValueArg<int> maxHotAllocations("", "maxhotallocations", "Fail if the hot paths allocate from the heap more times, default = -1 (no limit).", false, -1, "integer", cmd);
+		TCLAP::ValueArg<int> threads("", "threads", "Number of threads used for writing the output files.", false, static_cast<int>(SyntenyFinder::GetThreadsNumber()), "integer", cmd);
+		TCLAP::ValueArg<std::string> outFileDir("o", "outdir", "Directory where output files are written", false, ".", "dir name", cmd);
+		cmd.parse(argc, argv);
+
+		synthetic.genomes = genomes.getValue();
+		synthetic.genomeSize = genomeSize.getValue();
+		synthetic.chromosomes = chromosomes.getValue();
+		synthetic.segments = segments.getValue();
+		synthetic.rearrangements = rearrangements.getValue();
+		synthetic.repeats = repeats.getValue();
+		synthetic.divergence = divergence.getValue();
+		synthetic.seed = seed.getValue();
+		SyntenyFinder::SetThreadsNumber(std::max(threads.getValue(), 1));
+		SyntenyFinder::CreateOutDirectory(outFileDir.getValue());
+
+		std::vector<SyntenyFinder::FASTARecord> chrList;
+		std::vector<SyntenyFinder::TruthInstance> truth;
+		double generationStart = SyntenyFinder::GetWallClockTime();
+		SyntenyFinder::GenerateSyntheticGenomes(synthetic, chrList, truth);
+		double generationTime = SyntenyFinder::GetWallClockTime() - generationStart;
+		size_t totalSize = 0;
+		for(size_t i = 0; i < chrList.size(); i++)
+		{
+			totalSize += chrList[i].GetSequence().size();
+		}
+
+		if(keepInput.isSet())
+		{
+			SyntenyFinder::WriteSyntheticGenomes(chrList, outFileDir.getValue() + "/synthetic_genomes.fasta");
+			SyntenyFinder::WriteTruth(chrList, truth, outFileDir.getValue() + "/synthetic_truth.txt");
+		}
+
+		SyntenyFinder::ResetRunStats();
+		SyntenyFinder::PipelineParameters pipeline;
+		pipeline.stage = defaultParameters[parameters.getValue()];
+		pipeline.minBlockSize = minBlockSize.getValue();
+		pipeline.maxIterations = maxIterations.getValue();
+		pipeline.tempDir = inRAM.isSet() ? "" : outFileDir.getValue();
+		pipeline.bloomK = bloomK.getValue();
+		pipeline.fmIndex = fmIndex.isSet();
+		std::vector<std::vector<SyntenyFinder::BlockInstance> > history;
+		SyntenyFinder::FindSyntenyBlocks(chrList, pipeline, history);
+		const std::vector<SyntenyFinder::BlockInstance> & blockList = history.back();
+		{
+			using SyntenyFinder::TimedTask;
+			using SyntenyFinder::OutputGenerator;
+			SyntenyFinder::PhaseTimer timer("output");
+			OutputGenerator generator(chrList);
+			SyntenyFinder::BlockIndex index(blockList, chrList.size());
+			const std::string coordsFile = outFileDir.getValue() + "/blocks_coords.txt";
+			const std::string binaryCoordsFile = outFileDir.getValue() + "/blocks_coords.bin";
+			const std::string permutationsFile = outFileDir.getValue() + "/genomes_permutations.txt";
+			const std::string coverageFile = outFileDir.getValue() + "/coverage_report.txt";
+			const std::string sequencesFile = outFileDir.getValue() + "/blocks_sequences.fasta";
+			std::vector<TimedTask> writer;
+			writer.push_back(TimedTask(coordsFile, boost::bind(&OutputGenerator::ListBlocksIndices, boost::cref(generator), boost::cref(index), coordsFile)));
+			writer.push_back(TimedTask(binaryCoordsFile, boost::bind(&OutputGenerator::ListBlocksIndicesBinary, boost::cref(generator), boost::cref(index), binaryCoordsFile)));
+			writer.push_back(TimedTask(permutationsFile, boost::bind(&OutputGenerator::ListChromosomesAsPermutations, boost::cref(generator), boost::cref(index), permutationsFile)));
+			writer.push_back(TimedTask(coverageFile, boost::bind(&OutputGenerator::GenerateReport, boost::cref(generator), boost::cref(index), coverageFile)));
+			writer.push_back(TimedTask(sequencesFile, boost::bind(&OutputGenerator::ListBlocksSequences, boost::cref(generator), boost::cref(index), sequencesFile)));
+			SyntenyFinder::RunTasksConcurrently(writer);
+			for(std::vector<TimedTask>::const_iterator it = writer.begin(); it != writer.end(); ++it)
+			{
+				SyntenyFinder::RecordPhaseWallTime(it->name.substr(outFileDir.getValue().size() + 1), it->elapsed);
+			}
+		}
+
+		double wallTime = SyntenyFinder::GetRunWallTime();
+		SyntenyFinder::BlockAccuracy accuracy = SyntenyFinder::EvaluateBlocks(chrList, truth, blockList);
+		SyntenyFinder::WriteRunStats(outFileDir.getValue() + "/run_stats.json", threads.getValue());
+
+		double mbp = static_cast<double>(totalSize) / 1e6;
+		std::cout.setf(std::cout.fixed);
+		std::cout.precision(2);
+		std::cout << "Input: " << synthetic.genomes << " genomes, " << chrList.size() << " sequences, " << mbp << " Mbp";
+		std::cout << ", generated in " << generationTime << " seconds" << std::endl;
+		std::cout << "Phase\tWall time, s\tThroughput, Mbp/s" << std::endl;
+		std::vector<std::pair<std::string, double> > phase = SyntenyFinder::GetPhaseWallTimes();
+		phase.push_back(std::make_pair(std::string("total"), wallTime));
+		for(size_t i = 0; i < phase.size(); i++)
+		{
+			std::cout << phase[i].first << '\t' << phase[i].second << '\t';
+			if(phase[i].second > 0)
+			{
+				std::cout << mbp / phase[i].second;
+			}
+			else
+			{
+				std::cout << '-';
+			}
+
+			std::cout << std::endl;
+		}
+
+		std::cout << "Peak memory: " << static_cast<double>(SyntenyFinder::GetPeakMemoryUsage()) / (1 << 20) << " MB" << std::endl;
+		std::cout << "Blocks: " << accuracy.blocks << std::endl;
+		std::cout << "Recall: " << accuracy.recall << std::endl;
+		std::cout << "Precision: " << accuracy.precision << std::endl;
+		std::cout << "Consistent blocks: " << accuracy.consistency << std::endl;
+		uint64_t hotAllocations = SyntenyFinder::GetHotCounter(SyntenyFinder::HOT_PATH_ALLOCATION_COUNTER);
+		std::cout << "Hot path allocations: " << hotAllocations << " in " << SyntenyFinder::GetHotCounter(SyntenyFinder::REPLACE_COUNTER) << " replacements" << std::endl;
+		if(accuracy.recall < minRecall.getValue() || accuracy.precision < minPrecision.getValue())
+		{
+			std::cerr << "error: accuracy of the blocks is below the threshold" << std::endl;
+			return 1;
+		}
+
+		if(maxHotAllocations.getValue() >= 0 && hotAllocations > static_cast<uint64_t>(maxHotAllocations.getValue()))
+		{
+			std::cerr << "error: the hot paths allocate from the heap too often" << std::endl;
+			return 1;
+		}
+	}
+	catch (TCLAP::ArgException &e)
+	{
+		std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+		return 1;
+	}
+	catch (std::runtime_error & e)
+	{
+		std::cerr << "error: " << e.what() << std::endl;
+		return 1;
+	}
+	catch(...)
+	{
+		SyntenyFinder::TempFile::Cleanup();
+		return 1;
+	}
+
+	return 0;
+}
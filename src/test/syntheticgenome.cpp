@@ -0,0 +1,309 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#include "syntheticgenome.h"
+
+namespace SyntenyFinder
+{
+	namespace
+	{
+		const char NUCLEOTIDE[] = "ACGT";
+		const size_t MAX_INDEL_LENGTH = 10;
+		const size_t FASTA_LINE_LENGTH = 80;
+
+		//Xorshift generator, so the genomes are the same on every platform
+		class Random
+		{
+		public:
+			explicit Random(uint64_t seed): state_(seed * 2685821657736338717ULL + 1) {}
+			uint64_t Next()
+			{
+				state_ ^= state_ >> 12;
+				state_ ^= state_ << 25;
+				state_ ^= state_ >> 27;
+				return state_ * 2685821657736338717ULL;
+			}
+
+			size_t Uniform(size_t bound)
+			{
+				return bound == 0 ? 0 : static_cast<size_t>(Next() % bound);
+			}
+
+			double Real()
+			{
+				return static_cast<double>(Next() >> 11) / static_cast<double>(1ULL << 53);
+			}
+
+			char Nucleotide()
+			{
+				return NUCLEOTIDE[Uniform(4)];
+			}
+
+		private:
+			uint64_t state_;
+		};
+
+		typedef std::pair<size_t, bool> Placement;
+
+		std::string RandomSequence(Random & random, size_t length)
+		{
+			std::string ret(length, 'A');
+			for(size_t i = 0; i < length; i++)
+			{
+				ret[i] = random.Nucleotide();
+			}
+
+			return ret;
+		}
+
+		std::string Mutate(Random & random, const std::string & source, double divergence)
+		{
+			std::string ret;
+			ret.reserve(source.size() + source.size() / 10);
+			double indelRate = divergence / 10;
+			for(size_t i = 0; i < source.size(); i++)
+			{
+				double dice = random.Real();
+				if(dice < divergence)
+				{
+					char c = random.Nucleotide();
+					ret.push_back(c == source[i] ? NUCLEOTIDE[(std::find(NUCLEOTIDE, NUCLEOTIDE + 4, c) - NUCLEOTIDE + 1) % 4] : c);
+				}
+				else if(dice < divergence + indelRate)
+				{
+					ret.append(RandomSequence(random, random.Uniform(MAX_INDEL_LENGTH) + 1));
+					ret.push_back(source[i]);
+				}
+				else if(dice < divergence + indelRate * 2)
+				{
+					i += random.Uniform(MAX_INDEL_LENGTH);
+				}
+				else
+				{
+					ret.push_back(source[i]);
+				}
+			}
+
+			return ret;
+		}
+
+		std::string ReverseComplement(const std::string & source)
+		{
+			std::string ret(source.rbegin(), source.rend());
+			for(std::string::iterator it = ret.begin(); it != ret.end(); ++it)
+			{
+				*it = NUCLEOTIDE[3 - (std::find(NUCLEOTIDE, NUCLEOTIDE + 4, *it) - NUCLEOTIDE)];
+			}
+
+			return ret;
+		}
+
+		void Rearrange(Random & random, std::vector<Placement> & order)
+		{
+			size_t start = random.Uniform(order.size());
+			size_t end = start + 1 + random.Uniform(std::min(order.size() - start, order.size() / 4 + 1));
+			end = std::min(end, order.size());
+			if(random.Uniform(2) == 0)
+			{
+				std::reverse(order.begin() + start, order.begin() + end);
+				for(size_t i = start; i < end; i++)
+				{
+					order[i].second = !order[i].second;
+				}
+			}
+			else
+			{
+				std::vector<Placement> run(order.begin() + start, order.begin() + end);
+				order.erase(order.begin() + start, order.begin() + end);
+				size_t pos = random.Uniform(order.size() + 1);
+				order.insert(order.begin() + pos, run.begin(), run.end());
+			}
+		}
+
+		size_t Overlap(size_t start1, size_t end1, size_t start2, size_t end2)
+		{
+			size_t start = std::max(start1, start2);
+			size_t end = std::min(end1, end2);
+			return start < end ? end - start : 0;
+		}
+
+		//Total length of the union of the intervals, they are sorted by the function
+		size_t UnionLength(std::vector<std::pair<size_t, size_t> > & interval)
+		{
+			size_t ret = 0;
+			std::sort(interval.begin(), interval.end());
+			for(size_t i = 0; i < interval.size(); )
+			{
+				size_t runStart = interval[i].first;
+				size_t runEnd = interval[i].second;
+				for(++i; i < interval.size() && interval[i].first <= runEnd; ++i)
+				{
+					runEnd = std::max(runEnd, interval[i].second);
+				}
+
+				ret += runEnd - runStart;
+			}
+
+			return ret;
+		}
+	}
+
+	void GenerateSyntheticGenomes(const SyntheticGenomeParameters & parameters, std::vector<FASTARecord> & chrList, std::vector<TruthInstance> & truth)
+	{
+		if(parameters.genomes == 0 || parameters.segments == 0 || parameters.chromosomes == 0)
+		{
+			throw std::runtime_error("Number of genomes, segments and chromosomes must be positive");
+		}
+
+		Random random(parameters.seed);
+		size_t meanSegment = static_cast<size_t>(parameters.genomeSize * (1 - parameters.spacerFraction)) / parameters.segments;
+		size_t meanSpacer = static_cast<size_t>(parameters.genomeSize * parameters.spacerFraction) / (parameters.segments + parameters.chromosomes);
+		std::vector<std::string> segment(parameters.segments);
+		for(size_t i = 0; i < segment.size(); i++)
+		{
+			segment[i] = RandomSequence(random, meanSegment * 3 / 4 + random.Uniform(meanSegment / 2 + 1));
+		}
+
+		chrList.clear();
+		truth.clear();
+		for(size_t genome = 0; genome < parameters.genomes; genome++)
+		{
+			std::vector<Placement> order;
+			for(size_t i = 0; i < segment.size(); i++)
+			{
+				order.push_back(Placement(i, false));
+			}
+
+			for(size_t i = 0; i < parameters.rearrangements && genome > 0; i++)
+			{
+				Rearrange(random, order);
+			}
+
+			for(size_t i = 0; i < parameters.repeats; i++)
+			{
+				order.insert(order.begin() + random.Uniform(order.size() + 1), Placement(random.Uniform(segment.size()), random.Uniform(2) == 0));
+			}
+
+			size_t chromosomes = std::min(parameters.chromosomes, order.size());
+			for(size_t chr = 0; chr < chromosomes; chr++)
+			{
+				std::string sequence;
+				size_t chrId = chrList.size();
+				for(size_t i = order.size() * chr / chromosomes; i < order.size() * (chr + 1) / chromosomes; i++)
+				{
+					sequence.append(RandomSequence(random, meanSpacer / 2 + random.Uniform(meanSpacer + 1)));
+					std::string copy = Mutate(random, segment[order[i].first], parameters.divergence);
+					size_t start = sequence.size();
+					sequence.append(order[i].second ? ReverseComplement(copy) : copy);
+					truth.push_back(TruthInstance(order[i].first, chrId, start, sequence.size(), order[i].second ? -1 : +1));
+				}
+
+				sequence.append(RandomSequence(random, meanSpacer / 2 + random.Uniform(meanSpacer + 1)));
+				std::stringstream description;
+				description << "genome" << genome + 1 << "_chr" << chr + 1;
+				chrList.push_back(FASTARecord(sequence, description.str(), chrId));
+			}
+		}
+	}
+
+	void WriteSyntheticGenomes(const std::vector<FASTARecord> & chrList, const std::string & fileName)
+	{
+		std::ofstream out(fileName.c_str());
+		if(!out)
+		{
+			throw std::runtime_error(("Cannot open file " + fileName).c_str());
+		}
+
+		for(size_t i = 0; i < chrList.size(); i++)
+		{
+			const std::string & sequence = chrList[i].GetSequence();
+			out << '>' << chrList[i].GetDescription() << std::endl;
+			for(size_t pos = 0; pos < sequence.size(); pos += FASTA_LINE_LENGTH)
+			{
+				out << sequence.substr(pos, FASTA_LINE_LENGTH) << std::endl;
+			}
+		}
+	}
+
+	void WriteTruth(const std::vector<FASTARecord> & chrList, const std::vector<TruthInstance> & truth, const std::string & fileName)
+	{
+		std::ofstream out(fileName.c_str());
+		if(!out)
+		{
+			throw std::runtime_error(("Cannot open file " + fileName).c_str());
+		}
+
+		out << "Segment_id\tSeq_id\tStrand\tStart\tEnd\tDescription" << std::endl;
+		for(size_t i = 0; i < truth.size(); i++)
+		{
+			const TruthInstance & instance = truth[i];
+			out << instance.segment + 1 << '\t' << instance.chr + 1 << '\t' << (instance.strand > 0 ? '+' : '-') << '\t';
+			out << instance.start + 1 << '\t' << instance.end << '\t' << chrList[instance.chr].GetDescription() << std::endl;
+		}
+	}
+
+	BlockAccuracy EvaluateBlocks(const std::vector<FASTARecord> & chrList, const std::vector<TruthInstance> & truth, const std::vector<BlockInstance> & block)
+	{
+		typedef std::pair<size_t, size_t> Interval;
+		std::vector<std::vector<Interval> > found(chrList.size());
+		std::vector<std::vector<Interval> > foundInTruth(chrList.size());
+		std::map<int, std::vector<std::pair<size_t, int> > > blockSegment;
+		for(std::vector<BlockInstance>::const_iterator it = block.begin(); it != block.end(); ++it)
+		{
+			size_t chr = it->GetChrInstance().GetId();
+			size_t bestOverlap = 0;
+			std::pair<size_t, int> best(truth.size(), 0);
+			found[chr].push_back(Interval(it->GetStart(), it->GetEnd()));
+			for(std::vector<TruthInstance>::const_iterator jt = truth.begin(); jt != truth.end(); ++jt)
+			{
+				size_t overlap = jt->chr == chr ? Overlap(it->GetStart(), it->GetEnd(), jt->start, jt->end) : 0;
+				if(overlap > 0)
+				{
+					foundInTruth[chr].push_back(Interval(std::max(it->GetStart(), jt->start), std::min(it->GetEnd(), jt->end)));
+				}
+
+				if(overlap > bestOverlap)
+				{
+					bestOverlap = overlap;
+					best = std::make_pair(jt->segment, jt->strand * it->GetSign());
+				}
+			}
+
+			blockSegment[it->GetBlockId()].push_back(best);
+		}
+
+		double truthBp = 0;
+		double foundBp = 0;
+		double foundInTruthBp = 0;
+		for(size_t chr = 0; chr < chrList.size(); chr++)
+		{
+			foundBp += UnionLength(found[chr]);
+			foundInTruthBp += UnionLength(foundInTruth[chr]);
+		}
+
+		for(std::vector<TruthInstance>::const_iterator it = truth.begin(); it != truth.end(); ++it)
+		{
+			truthBp += it->end - it->start;
+		}
+
+		BlockAccuracy ret;
+		size_t consistent = 0;
+		for(std::map<int, std::vector<std::pair<size_t, int> > >::const_iterator it = blockSegment.begin(); it != blockSegment.end(); ++it)
+		{
+			const std::vector<std::pair<size_t, int> > & segment = it->second;
+			if(segment[0].first < truth.size() && static_cast<size_t>(std::count(segment.begin(), segment.end(), segment[0])) == segment.size())
+			{
+				consistent++;
+			}
+		}
+
+		ret.blocks = blockSegment.size();
+		ret.recall = truthBp > 0 ? foundInTruthBp / truthBp : 0;
+		ret.precision = foundBp > 0 ? foundInTruthBp / foundBp : 0;
+		ret.consistency = ret.blocks > 0 ? static_cast<double>(consistent) / ret.blocks : 0;
+		return ret;
+	}
+}
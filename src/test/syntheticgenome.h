@@ -0,0 +1,67 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#ifndef _SYNTHETIC_GENOME_H_
+#define _SYNTHETIC_GENOME_H_
+
+#include "../fasta.h"
+#include "../blockinstance.h"
+
+namespace SyntenyFinder
+{
+	//Parameters of a collection of genomes evolved from a common ancestor. The
+	//ancestor consists of "segments" unique segments separated by unique spacers.
+	//Each genome except the first one undergoes "rearrangements" random inversions
+	//and translocations of runs of segments, gets "repeats" extra copies of random
+	//segments, and each copy of a segment is mutated independently: substitutions
+	//occur with probability "divergence" per base, indels ten times less often.
+	struct SyntheticGenomeParameters
+	{
+		size_t genomes;
+		size_t genomeSize;
+		size_t chromosomes;
+		size_t segments;
+		size_t rearrangements;
+		size_t repeats;
+		double divergence;
+		double spacerFraction;
+		uint64_t seed;
+		SyntheticGenomeParameters(): genomes(3), genomeSize(1000000), chromosomes(1), segments(20), rearrangements(4),
+			repeats(1), divergence(0.01), spacerFraction(0.1), seed(1) {}
+	};
+
+	//A copy of an ancestral segment, i.e. a true instance of a synteny block
+	struct TruthInstance
+	{
+		size_t segment;
+		size_t chr;
+		size_t start;
+		size_t end;
+		int strand;
+		TruthInstance() {}
+		TruthInstance(size_t segment, size_t chr, size_t start, size_t end, int strand):
+			segment(segment), chr(chr), start(start), end(end), strand(strand) {}
+	};
+
+	//Recall and precision are measured in base pairs covered by the found blocks.
+	//A block is consistent if all its instances overlap mostly the copies of the same
+	//segment, in the same relative orientation.
+	struct BlockAccuracy
+	{
+		double recall;
+		double precision;
+		double consistency;
+		size_t blocks;
+		BlockAccuracy(): recall(0), precision(0), consistency(0), blocks(0) {}
+	};
+
+	void GenerateSyntheticGenomes(const SyntheticGenomeParameters & parameters, std::vector<FASTARecord> & chrList, std::vector<TruthInstance> & truth);
+	void WriteSyntheticGenomes(const std::vector<FASTARecord> & chrList, const std::string & fileName);
+	void WriteTruth(const std::vector<FASTARecord> & chrList, const std::vector<TruthInstance> & truth, const std::string & fileName);
+	BlockAccuracy EvaluateBlocks(const std::vector<FASTARecord> & chrList, const std::vector<TruthInstance> & truth, const std::vector<BlockInstance> & block);
+}
+
+#endif
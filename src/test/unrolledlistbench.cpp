@@ -0,0 +1,119 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#include <tclap/CmdLine.h>
+#include "../common.h"
+#include "../platform.h"
+#include "../unrolledlist.h"
+
+namespace
+{
+	typedef SyntenyFinder::unrolled_list<char, uint32_t, 25> List;
+	const char ERASED = ' ';
+
+	uint64_t NextRandom(uint64_t & state)
+	{
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		return state >> 33;
+	}
+}
+
+//Compares advancing of an unrolled list iterator by one element at a time with
+//the jump through the index of the chunks. The list is fragmented by random
+//erasures and insertions first, like the sequence after the bulge removal
+int main(int argc, char * argv[])
+{
+	try
+	{
+		TCLAP::CmdLine cmd("Benchmark of the random access to an unrolled list", ' ', VERSION);
+		TCLAP::ValueArg<size_t> size("", "size", "Number of elements, default = 4000000.", false, 4000000, "integer", cmd);
+		TCLAP::ValueArg<size_t> edits("", "edits", "Number of random insertions and erasures, default = 100000.", false, 100000, "integer", cmd);
+		TCLAP::ValueArg<size_t> queries("", "queries", "Number of queries for each step, default = 20000.", false, 20000, "integer", cmd);
+		cmd.parse(argc, argv);
+
+		uint64_t state = 1;
+		List list(ERASED);
+		std::string buf(size.getValue(), 'A');
+		list.insert(list.begin(), buf.begin(), buf.end());
+		std::vector<List::iterator> point;
+		for(size_t i = 0; i < edits.getValue(); i++)
+		{
+			List::iterator it = list.at(NextRandom(state) % list.size());
+			size_t length = NextRandom(state) % 50 + 1;
+			if(i % 2 == 0)
+			{
+				list.insert(it, buf.begin(), buf.begin() + length);
+			}
+			else
+			{
+				List::iterator end = it;
+				for(size_t j = 0; j < length && end != list.end(); j++, ++end);
+				list.erase(it, end);
+			}
+		}
+
+		if(static_cast<size_t>(std::distance(list.begin(), list.end())) != list.size())
+		{
+			throw std::runtime_error("The size of the list is wrong");
+		}
+
+		const size_t stepArray[] = {1, 4, 16, 64, 256, 1024, 5000, 15000};
+		std::cout << "step\tlinear_ns\tindexed_ns" << std::endl;
+		for(size_t s = 0; s < sizeof(stepArray) / sizeof(stepArray[0]); s++)
+		{
+			size_t step = stepArray[s];
+			std::vector<size_t> start(queries.getValue());
+			for(size_t i = 0; i < start.size(); i++)
+			{
+				start[i] = NextRandom(state) % (list.size() - step);
+			}
+
+			point.clear();
+			for(size_t i = 0; i < start.size(); i++)
+			{
+				point.push_back(list.at(start[i]));
+			}
+
+			std::vector<List::iterator> linear(point.size());
+			double time = SyntenyFinder::GetWallClockTime();
+			for(size_t i = 0; i < point.size(); i++)
+			{
+				linear[i] = SyntenyFinder::AdvanceForward(point[i], step);
+			}
+
+			double linearTime = SyntenyFinder::GetWallClockTime() - time;
+			std::vector<List::iterator> indexed(point.size());
+			time = SyntenyFinder::GetWallClockTime();
+			for(size_t i = 0; i < point.size(); i++)
+			{
+				indexed[i] = list.at(list.index_of(point[i]) + step);
+			}
+
+			double indexedTime = SyntenyFinder::GetWallClockTime() - time;
+			for(size_t i = 0; i < point.size(); i++)
+			{
+				if(linear[i] != indexed[i] || list.index_of(point[i]) != start[i])
+				{
+					throw std::runtime_error("The index gives a wrong position");
+				}
+			}
+
+			std::cout << step << '\t' << linearTime * 1e9 / point.size() << '\t' << indexedTime * 1e9 / point.size() << std::endl;
+		}
+	}
+	catch (TCLAP::ArgException &e)
+	{
+		std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+		return 1;
+	}
+	catch (std::runtime_error & e)
+	{
+		std::cerr << "error: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
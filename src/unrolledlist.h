@@ -28,6 +28,16 @@ namespace SyntenyFinder
 			T erased_value;
 			size_t 	count;
 			bool	is_end;
+			//node of the treap over the chunks in the list order, "total" is
+			//the number of elements in the subtree
+			chunk * left;
+			chunk * right;
+			chunk * parent;
+			size_t total;
+			uint32_t priority;
+			typename std::list<chunk>::iterator self;
+			//value of the user, a new chunk gets 0
+			uint32_t tag;
 		};
 
 	public:
@@ -50,6 +60,10 @@ namespace SyntenyFinder
 			iterator& operator = (const iterator & to_copy);
 			chunk_size& get_padding_int();
 			const chunk_size& get_padding_int() const;			
+			//Identifies the chunk of the element, elements move between chunks only on insertion
+			const void* get_chunk_id() const;
+			//Tag of the chunk of the element, the list never changes it
+			chunk_size& get_chunk_tag() const;
 		private:
 			friend class unrolled_list;
 			typename std::list<chunk>::iterator m_ListPos;
@@ -107,6 +121,24 @@ namespace SyntenyFinder
 
 		typedef boost::function<void (iterator, iterator)> notify_func;
 
+		//Notifier that calls the functions if they are set
+		struct function_notifier
+		{
+			function_notifier(notify_func before, notify_func after): before_func(before), after_func(after) {}
+			void before(iterator begin, iterator end)
+			{
+				if (before_func) before_func(begin, end);
+			}
+
+			void after(iterator begin, iterator end)
+			{
+				if (after_func) after_func(begin, end);
+			}
+
+			notify_func before_func;
+			notify_func after_func;
+		};
+
 		size_t  size()  const;
 		bool    empty() const;
 
@@ -126,11 +158,24 @@ namespace SyntenyFinder
 		reverse_iterator 	insert(reverse_iterator target, out_it source_begin, out_it source_end,
 									notify_func before = 0, notify_func after = 0);
 
+		//Same, but the notifications are statically dispatched to notify.before(begin, end)
+		//and notify.after(begin, end) for the range of the elements moved to a new chunk
+		template<class out_it, class notifier>
+		iterator 			insert(iterator target, out_it source_begin, out_it source_end, notifier & notify);
+
+		template<class out_it, class notifier>
+		reverse_iterator 	insert(reverse_iterator target, out_it source_begin, out_it source_end, notifier & notify);
+
 		iterator 			insert(iterator pos, const T & value);
 		reverse_iterator 	insert(reverse_iterator pos, const T & value);
 
 		void 				push_back(const T & value);
 
+		//Number of elements before the position, O(log n)
+		size_t				index_of(iterator pos);
+		//Iterator to the element with the index, end() if there is none, O(log n)
+		iterator			at(size_t index);
+
 		void				debugPrintList();
 		size_t				debugGetNodesCount(){return m_Data.size();}
 	private:
@@ -141,6 +186,14 @@ namespace SyntenyFinder
 		void				lazyUpdateBeginEnd();
 		void				updateEndMark();
 
+		static size_t		index_total(const chunk * node);
+		void				index_rotate(chunk * node);
+		void				index_link(type_iter listPos);
+		void				index_unlink(chunk * node);
+		void				index_add(chunk * node, size_t delta);
+		void				index_sub(chunk * node, size_t delta);
+		void				index_rebuild();
+
 		std::list<chunk>    m_Data;
 		size_t              m_Size;
 		T					m_ErasedValue;
@@ -151,13 +204,22 @@ namespace SyntenyFinder
 		iterator			m_End;
 		type_iter			m_LastChunk;
 		bool				m_LastChunkSet;
+
+		chunk *				m_Root;
+		uint32_t			m_Seed;
 	};
 
 	template<class T, class A, size_t NODE_SIZE>
 	unrolled_list<T, A, NODE_SIZE>::chunk::chunk(const T& _erased_value):
 		erased_value(_erased_value),
 		count(0),
-		is_end(false)
+		is_end(false),
+		left(0),
+		right(0),
+		parent(0),
+		total(0),
+		priority(0),
+		tag(0)
 	{
 		std::fill(data, data + NODE_SIZE, erased_value);
 	}
@@ -238,6 +300,19 @@ namespace SyntenyFinder
 		return m_PaddingInt;
 	}
 
+	template<class T, class A, size_t NODE_SIZE>
+	const void* unrolled_list<T, A, NODE_SIZE>::iterator::get_chunk_id() const
+	{
+		return &*m_ListPos;
+	}
+
+	template<class T, class A, size_t NODE_SIZE>
+	typename unrolled_list<T, A, NODE_SIZE>::chunk_size&
+	unrolled_list<T, A, NODE_SIZE>::iterator::get_chunk_tag() const
+	{
+		return m_ListPos->tag;
+	}
+
 	template<class T, class A, size_t NODE_SIZE>
 	A& unrolled_list<T, A, NODE_SIZE>::iterator::meta() const
 	{
@@ -350,7 +425,9 @@ namespace SyntenyFinder
 		m_BeginEndDirty(false),
 		m_Begin(create_iterator(m_Data.begin(), 0)),
 		m_End(create_iterator(m_Data.end(), 0)),
-		m_LastChunkSet(false)
+		m_LastChunkSet(false),
+		m_Root(0),
+		m_Seed(1)
 	{
 	}
 
@@ -363,7 +440,9 @@ namespace SyntenyFinder
 		m_BeginEndDirty(false),
 		m_Begin(create_iterator(m_Data.begin(), 0)),
 		m_End(create_iterator(m_Data.end(), 0)),
-		m_LastChunkSet(false)
+		m_LastChunkSet(false),
+		m_Root(0),
+		m_Seed(1)
 	{
 	}
 
@@ -377,8 +456,10 @@ namespace SyntenyFinder
 		m_LastChunk(other.m_LastChunk),
 		m_LastChunkSet(other.m_LastChunkSet),
 		m_Begin(other.m_Begin),
-		m_End(other.m_End)
+		m_End(other.m_End),
+		m_Seed(other.m_Seed)
 	{
+		this->index_rebuild();
 	}
 
 	template<class T, class A, size_t NODE_SIZE>
@@ -393,6 +474,220 @@ namespace SyntenyFinder
 		m_LastChunkSet = other.m_LastChunkSet;
 		m_Begin = other.m_Begin;
 		m_End = other.m_End;
+		m_Seed = other.m_Seed;
+		this->index_rebuild();
+	}
+
+	template<class T, class A, size_t NODE_SIZE>
+	size_t unrolled_list<T, A, NODE_SIZE>::index_total(const chunk * node)
+	{
+		return node == 0 ? 0 : node->total;
+	}
+
+	//Lifts the node over its parent keeping the order of the chunks
+	template<class T, class A, size_t NODE_SIZE>
+	void unrolled_list<T, A, NODE_SIZE>::index_rotate(chunk * node)
+	{
+		chunk * parent = node->parent;
+		chunk * grand = parent->parent;
+		if (parent->left == node)
+		{
+			parent->left = node->right;
+			if (node->right != 0) node->right->parent = parent;
+			node->right = parent;
+		}
+		else
+		{
+			parent->right = node->left;
+			if (node->left != 0) node->left->parent = parent;
+			node->left = parent;
+		}
+
+		parent->parent = node;
+		node->parent = grand;
+		if (grand == 0)
+		{
+			m_Root = node;
+		}
+		else if (grand->left == parent)
+		{
+			grand->left = node;
+		}
+		else
+		{
+			grand->right = node;
+		}
+
+		parent->total = index_total(parent->left) + index_total(parent->right) + parent->count;
+		node->total = index_total(node->left) + index_total(node->right) + node->count;
+	}
+
+	//Puts a chunk just inserted into the list to the treap
+	template<class T, class A, size_t NODE_SIZE>
+	void unrolled_list<T, A, NODE_SIZE>::index_link(type_iter listPos)
+	{
+		chunk * node = &*listPos;
+		m_Seed = m_Seed * 1103515245 + 12345;
+		node->self = listPos;
+		node->left = node->right = node->parent = 0;
+		node->total = node->count;
+		node->priority = m_Seed;
+		if (m_Root == 0)
+		{
+			m_Root = node;
+			return;
+		}
+
+		//the node becomes the right child of the previous chunk or the left child of the next one
+		chunk * prev = 0;
+		if (listPos != m_Data.begin())
+		{
+			type_iter prevPos = listPos;
+			prev = &*--prevPos;
+		}
+
+		if (prev != 0 && prev->right == 0)
+		{
+			prev->right = node;
+			node->parent = prev;
+		}
+		else
+		{
+			type_iter nextPos = listPos;
+			chunk * next = &*++nextPos;
+			assert(next->left == 0);
+			next->left = node;
+			node->parent = next;
+		}
+
+		this->index_add(node->parent, node->count);
+		while (node->parent != 0 && node->parent->priority < node->priority)
+		{
+			this->index_rotate(node);
+		}
+	}
+
+	//Removes a chunk from the treap before it is erased from the list
+	template<class T, class A, size_t NODE_SIZE>
+	void unrolled_list<T, A, NODE_SIZE>::index_unlink(chunk * node)
+	{
+		while (node->left != 0 || node->right != 0)
+		{
+			bool takeLeft = node->right == 0 || (node->left != 0 && node->left->priority > node->right->priority);
+			this->index_rotate(takeLeft ? node->left : node->right);
+		}
+
+		this->index_sub(node->parent, node->count);
+		if (node->parent == 0)
+		{
+			m_Root = 0;
+		}
+		else if (node->parent->left == node)
+		{
+			node->parent->left = 0;
+		}
+		else
+		{
+			node->parent->right = 0;
+		}
+	}
+
+	template<class T, class A, size_t NODE_SIZE>
+	void unrolled_list<T, A, NODE_SIZE>::index_add(chunk * node, size_t delta)
+	{
+		for (; node != 0; node = node->parent)
+		{
+			node->total += delta;
+		}
+	}
+
+	template<class T, class A, size_t NODE_SIZE>
+	void unrolled_list<T, A, NODE_SIZE>::index_sub(chunk * node, size_t delta)
+	{
+		for (; node != 0; node = node->parent)
+		{
+			node->total -= delta;
+		}
+	}
+
+	template<class T, class A, size_t NODE_SIZE>
+	void unrolled_list<T, A, NODE_SIZE>::index_rebuild()
+	{
+		m_Root = 0;
+		for (type_iter itList = m_Data.begin(); itList != m_Data.end(); ++itList)
+		{
+			this->index_link(itList);
+		}
+	}
+
+	template<class T, class A, size_t NODE_SIZE>
+	size_t unrolled_list<T, A, NODE_SIZE>::index_of(iterator pos)
+	{
+		if (pos.m_ListPos == m_Data.end())
+		{
+			return m_Size;
+		}
+
+		const chunk * node = &*pos.m_ListPos;
+		size_t ret = index_total(node->left);
+		for (const chunk * now = node; now->parent != 0; now = now->parent)
+		{
+			if (now->parent->right == now)
+			{
+				ret += index_total(now->parent->left) + now->parent->count;
+			}
+		}
+
+		for (size_t arrayPos = 0; arrayPos < pos.m_ArrayPos; ++arrayPos)
+		{
+			if (node->data[arrayPos] != m_ErasedValue)
+			{
+				++ret;
+			}
+		}
+
+		return ret;
+	}
+
+	template<class T, class A, size_t NODE_SIZE>
+	typename unrolled_list<T, A, NODE_SIZE>::iterator
+	unrolled_list<T, A, NODE_SIZE>::at(size_t index)
+	{
+		if (index >= m_Size)
+		{
+			return this->end();
+		}
+
+		chunk * node = m_Root;
+		for (;;)
+		{
+			size_t left = index_total(node->left);
+			if (index < left)
+			{
+				node = node->left;
+			}
+			else if (index < left + node->count)
+			{
+				index -= left;
+				break;
+			}
+			else
+			{
+				index -= left + node->count;
+				node = node->right;
+			}
+		}
+
+		size_t arrayPos = 0;
+		for (;; ++arrayPos)
+		{
+			if (node->data[arrayPos] != m_ErasedValue && index-- == 0)
+			{
+				break;
+			}
+		}
+
+		return create_iterator(node->self, arrayPos);
 	}
 
 	template<class T, class A, size_t NODE_SIZE>
@@ -481,10 +776,12 @@ namespace SyntenyFinder
 			assert(start.m_ListPos->count > 0);
 			assert(start.m_ListPos->count <= NODE_SIZE);
 			--start.m_ListPos->count;
+			this->index_sub(&*start.m_ListPos, 1);
 			if (start.m_ListPos->count == 0)
 			{
 				iterator old = start;
 				++old;
+				this->index_unlink(&*start.m_ListPos);
 				m_Data.erase(start.m_ListPos);
 				start = old;
 			}
@@ -563,6 +860,15 @@ namespace SyntenyFinder
 	typename unrolled_list<T, A, NODE_SIZE>::iterator
 	unrolled_list<T, A, NODE_SIZE>::insert(iterator target, out_it source_begin, out_it source_end,
 										notify_func notify_before, notify_func notify_after)
+	{
+		function_notifier notify(notify_before, notify_after);
+		return this->insert(target, source_begin, source_end, notify);
+	}
+
+	template<class T, class A, size_t NODE_SIZE>
+	template <class out_it, class notifier>
+	typename unrolled_list<T, A, NODE_SIZE>::iterator
+	unrolled_list<T, A, NODE_SIZE>::insert(iterator target, out_it source_begin, out_it source_end, notifier & notify)
 	{
 		assert(m_ErasedValueSet);
 		assert(source_begin != source_end);
@@ -593,6 +899,7 @@ namespace SyntenyFinder
 			if (itList == m_Data.end())
 			{
 				itList = m_Data.insert(itList, chunk(m_ErasedValue));
+				this->index_link(itList);
 				this->updateEndMark();
 			}
 
@@ -603,35 +910,34 @@ namespace SyntenyFinder
 				if (arrayPos == 0)
 				{
 					itList = m_Data.insert(itList, chunk(m_ErasedValue));
+					this->index_link(itList);
 					this->updateEndMark();
 				}
 				//insert new chunk and move previous elements to it
 				else
 				{
 					//before notification
-					if (notify_before)
-					{
-						iterator inv_before_begin = this->create_iterator(itList, arrayPos);
-						iterator inv_before_end = this->create_iterator(itList, 0);
+					iterator inv_before_begin = this->create_iterator(itList, arrayPos);
+					iterator inv_before_end = this->create_iterator(itList, 0);
 
-						for (size_t index = NODE_SIZE - 1; index >= arrayPos; --index)
+					for (size_t index = NODE_SIZE - 1; index >= arrayPos; --index)
+					{
+						if (itList->data[index] != m_ErasedValue)
 						{
-							if (itList->data[index] != m_ErasedValue)
-							{
-								inv_before_end.m_ArrayPos = static_cast<chunk_size>(index);
-								break;
-							}
+							inv_before_end.m_ArrayPos = static_cast<chunk_size>(index);
+							break;
 						}
-						++inv_before_end;
-
-						m_BeginEndDirty = true;
-						notify_before(inv_before_begin, inv_before_end);
 					}
+					++inv_before_end;
+
+					m_BeginEndDirty = true;
+					notify.before(inv_before_begin, inv_before_end);
 
 					//add new chunk
 					type_iter nextNode = itList;
 					++nextNode;
 					type_iter newChunk = m_Data.insert(nextNode, chunk(m_ErasedValue));
+					this->index_link(newChunk);
 					this->updateEndMark();
 
 					size_t idFrom = arrayPos;
@@ -651,20 +957,21 @@ namespace SyntenyFinder
 						++idFrom;
 					}
 
+					this->index_sub(&*itList, idTo);
+					this->index_add(&*newChunk, idTo);
+
 					//for after notifications
-					if (notify_after)
-					{
-						assert(!invalidated);
-						inv_after_begin = this->create_iterator(newChunk, 0);
-						inv_after_end = this->create_iterator(newChunk, idTo - 1);
-						invalidated = true;
-					}
+					assert(!invalidated);
+					inv_after_begin = this->create_iterator(newChunk, 0);
+					inv_after_end = this->create_iterator(newChunk, idTo - 1);
+					invalidated = true;
 				}
 			}
 
 			//inserting new element over erased value
 			itList->data[arrayPos] = *source_begin;
 			++itList->count;
+			this->index_add(&*itList, 1);
 			++source_begin;
 
 			if (!return_set)
@@ -687,7 +994,7 @@ namespace SyntenyFinder
 		if (invalidated)
 		{
 			++inv_after_end;
-			notify_after(inv_after_begin, inv_after_end);
+			notify.after(inv_after_begin, inv_after_end);
 		}
 
 		return to_return;
@@ -698,6 +1005,15 @@ namespace SyntenyFinder
 	typename unrolled_list<T, A, NODE_SIZE>::reverse_iterator
 	unrolled_list<T, A, NODE_SIZE>::insert(reverse_iterator target, out_it source_begin, out_it source_end,
 										notify_func notify_before, notify_func notify_after)
+	{
+		function_notifier notify(notify_before, notify_after);
+		return this->insert(target, source_begin, source_end, notify);
+	}
+
+	template<class T, class A, size_t NODE_SIZE>
+	template <class out_it, class notifier>
+	typename unrolled_list<T, A, NODE_SIZE>::reverse_iterator
+	unrolled_list<T, A, NODE_SIZE>::insert(reverse_iterator target, out_it source_begin, out_it source_end, notifier & notify)
 	{
 		assert(m_ErasedValueSet);
 		assert(source_begin != source_end);
@@ -736,7 +1052,9 @@ namespace SyntenyFinder
 		{
 			if (itList == m_Data.rend())
 			{
-				itList = std::reverse_iterator<type_iter> ( m_Data.insert(itList.base(), chunk(m_ErasedValue)) );
+				type_iter inserted = m_Data.insert(itList.base(), chunk(m_ErasedValue));
+				this->index_link(inserted);
+				itList = std::reverse_iterator<type_iter> (inserted);
 				--itList;
 				this->updateEndMark();
 			}
@@ -745,41 +1063,42 @@ namespace SyntenyFinder
 			{
 				if (arrayPos == NODE_SIZE - 1)
 				{
-					itList = std::reverse_iterator<type_iter> ( m_Data.insert(itList.base(), chunk(m_ErasedValue)) );
+					type_iter inserted = m_Data.insert(itList.base(), chunk(m_ErasedValue));
+					this->index_link(inserted);
+					itList = std::reverse_iterator<type_iter> (inserted);
 					this->updateEndMark();
 					--itList;
 				}
 				else
 				{
 					//before notification
-					if (notify_before)
-					{
-						iterator inv_before_end = this->create_iterator(--itList.base(), arrayPos);
-						iterator inv_before_begin = this->create_iterator(--itList.base(), 0);
+					iterator inv_before_end = this->create_iterator(--itList.base(), arrayPos);
+					iterator inv_before_begin = this->create_iterator(--itList.base(), 0);
 
-						for (size_t index = 0; index <= arrayPos; ++index)
+					for (size_t index = 0; index <= arrayPos; ++index)
+					{
+						if (itList->data[index] != m_ErasedValue)
 						{
-							if (itList->data[index] != m_ErasedValue)
-							{
-								inv_before_begin.m_ArrayPos = static_cast<chunk_size>(index);
-								break;
-							}
+							inv_before_begin.m_ArrayPos = static_cast<chunk_size>(index);
+							break;
 						}
-						++inv_before_end;
-
-						m_BeginEndDirty = true;
-						notify_before(inv_before_begin, inv_before_end);
 					}
+					++inv_before_end;
+
+					m_BeginEndDirty = true;
+					notify.before(inv_before_begin, inv_before_end);
 
 					//adding new chunk
 					type_iter nextNode = --itList.base();
 					++itList;	//prevent invalidation if itList.base() == end()
 					type_iter newChunk = m_Data.insert(nextNode, chunk(m_ErasedValue));
+					this->index_link(newChunk);
 					--itList;
 					this->updateEndMark();
 
 					size_t idFrom = arrayPos;
 					size_t idTo = NODE_SIZE - 1;
+					size_t moved = 0;
 					for (;;)
 					{
 						if (itList->data[idFrom] != m_ErasedValue)
@@ -789,6 +1108,7 @@ namespace SyntenyFinder
 							++newChunk->count;
 							itList->data[idFrom] = m_ErasedValue;
 							--itList->count;
+							++moved;
 						}
 						if (idFrom > 0)
 						{
@@ -801,20 +1121,21 @@ namespace SyntenyFinder
 						}
 					}
 
+					this->index_sub(&*itList, moved);
+					this->index_add(&*newChunk, moved);
+
 					//after notifications
-					if (notify_after)
-					{
-						assert(!invalidated);
-						inv_after_end = this->create_iterator(newChunk, NODE_SIZE - 1);
-						inv_after_begin = this->create_iterator(newChunk, idTo);
-						invalidated = true;
-					}
+					assert(!invalidated);
+					inv_after_end = this->create_iterator(newChunk, NODE_SIZE - 1);
+					inv_after_begin = this->create_iterator(newChunk, idTo);
+					invalidated = true;
 				}
 			}
 
 			//insert over erased value
 			itList->data[arrayPos] = *source_begin;
 			++itList->count;
+			this->index_add(&*itList, 1);
 			++source_begin;
 
 			if (!return_set)
@@ -840,7 +1161,7 @@ namespace SyntenyFinder
 		if (invalidated)
 		{
 			++inv_after_end;
-			notify_after(inv_after_begin, inv_after_end);
+			notify.after(inv_after_begin, inv_after_end);
 		}
 		return to_return;
 	}
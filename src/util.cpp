@@ -6,6 +6,7 @@
 
 #include "util.h"
 
+const std::string VERSION("3.0.7");
 const std::string DELIMITER(80, '-');
 
 std::vector<std::pair<int, int> > ReadStageFile(const std::string & fileName)
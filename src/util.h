@@ -9,6 +9,7 @@
 
 #include "blockfinder.h"
 #include "outputgenerator.h"
+#include "parallel.h"
 
 void SignalHandler(int sig);
 std::vector<std::pair<int, int> > FarStageFile();
@@ -0,0 +1,76 @@
+"""A reader of the binary file with coordinates of synteny blocks (blocks_coords.bin).
+
+The file is mmapped, so opening is cheap and the instances of a block or of a
+sequence are fetched without parsing the whole file. See blockcoords.h for the
+description of the format. Example:
+
+	coords = BlockCoords('blocks_coords.bin')
+	for instance in coords.block(1):
+		print instance.chr_num, instance.strand, instance.start, instance.end
+"""
+
+import mmap
+import struct
+import collections
+
+MAGIC = b'SIBBLKS1'
+VERSION = 1
+HEADER = struct.Struct('<8sIIII5Q')
+RECORD = struct.Struct('<iIII')
+INDEX = struct.Struct('<I')
+CHR_HEADER = struct.Struct('<QI')
+
+# chr_num is one-based as Seq_id in blocks_coords.txt, start > end for the negative strand
+BlockInstance = collections.namedtuple('BlockInstance', ['id', 'strand', 'chr_num', 'start', 'end'])
+Sequence = collections.namedtuple('Sequence', ['description', 'size'])
+
+class BlockCoords(object):
+	def __init__(self, file_name):
+		self._file = open(file_name, 'rb')
+		self._data = mmap.mmap(self._file.fileno(), 0, access=mmap.ACCESS_READ)
+		header = HEADER.unpack_from(self._data, 0)
+		if header[0] != MAGIC or header[1] != VERSION:
+			raise ValueError('%s is not a blocks coordinates file or has unsupported version' % file_name)
+		self._chr_number, self._instance_number, self._max_block_id = header[2:5]
+		self._record, self._block_index, self._chr_order, self._chr_index, chr_table = header[5:]
+		self.sequences = []
+		for _ in range(self._chr_number):
+			size, length = CHR_HEADER.unpack_from(self._data, chr_table)
+			chr_table += CHR_HEADER.size
+			description = self._data[chr_table:chr_table + length].decode('ascii', 'replace')
+			chr_table += length
+			self.sequences.append(Sequence(description=description, size=size))
+
+	def close(self):
+		self._data.close()
+		self._file.close()
+
+	def _index(self, offset, i):
+		return INDEX.unpack_from(self._data, offset + i * INDEX.size)[0]
+
+	def _instance(self, i):
+		signed_id, chr, start, end = RECORD.unpack_from(self._data, self._record + i * RECORD.size)
+		return BlockInstance(id=abs(signed_id), strand='+' if signed_id > 0 else '-', chr_num=chr + 1, start=start, end=end)
+
+	def block_ids(self):
+		return [block_id for block_id in range(self._max_block_id + 1)
+				if self._index(self._block_index, block_id) < self._index(self._block_index, block_id + 1)]
+
+	def block(self, block_id):
+		if block_id < 0 or block_id > self._max_block_id:
+			return []
+		start = self._index(self._block_index, block_id)
+		end = self._index(self._block_index, block_id + 1)
+		return [self._instance(i) for i in range(start, end)]
+
+	def blocks(self):
+		ret = collections.OrderedDict()
+		for i in range(self._instance_number):
+			instance = self._instance(i)
+			ret.setdefault(instance.id, []).append(instance)
+		return ret
+
+	def sequence_blocks(self, chr_num):
+		start = self._index(self._chr_index, chr_num - 1)
+		end = self._index(self._chr_index, chr_num)
+		return [self._instance(self._index(self._chr_order, i)) for i in range(start, end)]
@@ -5,12 +5,18 @@
 //****************************************************************************
 
 #include "indexedsequence.h"
+#include "runstats.h"
+#include "parallel.h"
 
 namespace SyntenyFinder
 {
 	const char IndexedSequence::SEPARATION_CHAR = '#';
 	namespace
 	{
+		const size_t MIN_SCAN_CHUNK_SIZE = 1 << 16;
+		//Length of the suffix of a k-mer checked before the backward search of its reverse complement
+		const size_t PROBE_SIZE = 32;
+
 		class CharSet
 		{
 		public:
@@ -41,21 +47,27 @@ namespace SyntenyFinder
 			std::string set;
 		};
 
-		void GetHeight(const std::string & str, const std::vector<saidx_t> & order, const std::vector<saidx_t> & pos, std::vector<Size> & height)
+		//Marks the suffixes that share the first k chars with the previous suffix. The LCP
+		//values are computed as in Kasai et al., but the comparison stops at k
+		void GetExtensionBits(const std::string & str, const std::vector<saidx_t> & order, const std::vector<saidx_t> & pos, size_t k, BitVector & extension)
 		{
 			size_t n = pos.size();
-			height.assign(n, 0);
+			extension.Assign(n);
 			for (size_t i = 0, h = 0; i < n; ++i)
 			{
 				if (pos[i] > 0)
 				{
 					size_t j = order[pos[i] - 1];
-					while (i + h < n && j + h < n && str[i + h] == str[j + h])
+					while (h < k && i + h < n && j + h < n && str[i + h] == str[j + h])
 					{
 						h++;
 					}
 
-					height[pos[i]] = static_cast<saidx_t>(h);
+					if (h >= k)
+					{
+						extension.Set(pos[i]);
+					}
+
 					if (h > 0)
 					{
 						h--;
@@ -64,6 +76,137 @@ namespace SyntenyFinder
 			}
 		}
 
+		//Rank structure over the BWT of a text on the alphabet of the separation char and
+		//the definite bases. Backward search with it gives the suffix array interval of a
+		//pattern, or the insertion point of the pattern if it does not occur
+		class FMIndex
+		{
+		public:
+			FMIndex(const std::string & text, const std::vector<saidx_t> & order): bwt_(text.size(), IndexedSequence::SEPARATION_CHAR), count_(DEFINITE_BASE.size(), 0)
+			{
+				std::vector<size_t> base(DEFINITE_BASE.size(), 0);
+				for(size_t i = 0; i < text.size(); i++)
+				{
+					if(order[i] > 0)
+					{
+						bwt_[i] = text[order[i] - 1];
+					}
+
+					if(text[i] == IndexedSequence::SEPARATION_CHAR)
+					{
+						count_[0]++;
+					}
+					else
+					{
+						base[Code(text[i])]++;
+					}
+				}
+
+				//Suffixes that start with the separation char precede the bases
+				for(size_t code = 1; code < DEFINITE_BASE.size(); code++)
+				{
+					count_[code] = count_[code - 1] + base[code - 1];
+				}
+
+				occ_.assign((text.size() / BLOCK_SIZE + 1) * DEFINITE_BASE.size(), 0);
+				std::vector<size_t> now(DEFINITE_BASE.size(), 0);
+				for(size_t i = 0; i < text.size(); i++)
+				{
+					if(i % BLOCK_SIZE == 0)
+					{
+						std::copy(now.begin(), now.end(), occ_.begin() + i / BLOCK_SIZE * DEFINITE_BASE.size());
+					}
+
+					if(bwt_[i] != IndexedSequence::SEPARATION_CHAR)
+					{
+						now[Code(bwt_[i])]++;
+					}
+				}
+
+				if(text.size() % BLOCK_SIZE == 0)
+				{
+					std::copy(now.begin(), now.end(), occ_.begin() + text.size() / BLOCK_SIZE * DEFINITE_BASE.size());
+				}
+			}
+
+			//Turns [start, end) of a pattern into the interval of the pattern prepended by ch
+			bool Extend(size_t & start, size_t & end, char ch) const
+			{
+				size_t code = Code(ch);
+				start = count_[code] + Occ(code, start);
+				end = count_[code] + Occ(code, end);
+				return start < end;
+			}
+
+		private:
+			static const size_t BLOCK_SIZE = 64;
+			std::string bwt_;
+			std::vector<uint32_t> occ_;
+			std::vector<size_t> count_;
+
+			static size_t Code(char ch)
+			{
+				size_t ret = DEFINITE_BASE.find(ch);
+				return ret == std::string::npos ? DEFINITE_BASE.size() - 1 : ret;
+			}
+
+			size_t Occ(size_t code, size_t idx) const
+			{
+				size_t ret = occ_[idx / BLOCK_SIZE * DEFINITE_BASE.size() + code];
+				char ch = DEFINITE_BASE[code];
+				for(size_t i = idx - idx % BLOCK_SIZE; i < idx; i++)
+				{
+					ret += bwt_[i] == ch ? 1 : 0;
+				}
+
+				return ret;
+			}
+		};
+
+		char Complement(char ch)
+		{
+			return ch == IndexedSequence::SEPARATION_CHAR ? ch : DNASequence::Translate(ch);
+		}
+
+		//A k-mer given by its occurrence on the positive strand, possibly reverse complemented
+		struct KMerRef
+		{
+			size_t pos;
+			bool reverse;
+			size_t owner;
+			KMerRef() {}
+			KMerRef(size_t pos, bool reverse, size_t owner): pos(pos), reverse(reverse), owner(owner) {}
+		};
+
+		class KMerLess
+		{
+		public:
+			KMerLess(const std::string & text, size_t k): text_(text), k_(k) {}
+			bool operator()(const KMerRef & a, const KMerRef & b) const
+			{
+				for(size_t i = 0; i < k_; i++)
+				{
+					char ach = At(a, i);
+					char bch = At(b, i);
+					if(ach != bch)
+					{
+						return ach < bch;
+					}
+				}
+
+				return false;
+			}
+
+		private:
+			const std::string & text_;
+			size_t k_;
+
+			char At(const KMerRef & ref, size_t i) const
+			{
+				return ref.reverse ? Complement(text_[ref.pos + k_ - 1 - i]) : text_[ref.pos + i];
+			}
+		};
+
 		bool Bifurcation(const CharSet & set)
 		{
 			return set.Size() > 1 || set.In(IndexedSequence::SEPARATION_CHAR);
@@ -98,6 +241,7 @@ namespace SyntenyFinder
 
 		FilePtr CreateFileWithSA(const std::string & superGenome, const std::string & tempDir)
 		{
+			PhaseTimer timer("suffix_array");
 			FilePtr posFile(new TempFile(tempDir));
 			std::vector<saidx_t> pos(superGenome.size());
 			divsufsort(reinterpret_cast<const sauchar_t*>(superGenome.c_str()), &pos[0], static_cast<saidx_t>(pos.size()));
@@ -120,50 +264,50 @@ namespace SyntenyFinder
 			posFile->Rewind();
 		}
 
-		FilePtr CalculateLCP(const std::string & superGenome, std::vector<saidx_t> & lcp, const std::string & tempDir)
+		FilePtr CalculateExtensionBits(const std::string & superGenome, size_t k, BitVector & extension, const std::string & tempDir)
 		{
-			FilePtr lcpFile(new TempFile(tempDir));
 			FilePtr posFile = CreateFileWithSA(superGenome, tempDir);
-			{
-				std::vector<saidx_t> phi(superGenome.size(), 0);
-				FindPhi(phi, posFile);
+			PhaseTimer timer("lcp");
+			std::vector<saidx_t> phi(superGenome.size(), 0);
+			FindPhi(phi, posFile);
 
-				saidx_t l = 0;
-				for(size_t i = 0; i < superGenome.size(); i++)
+			size_t l = 0;
+			for(size_t i = 0; i < superGenome.size(); i++)
+			{
+				while(l < k && superGenome[i + l] == superGenome[phi[i] + l])
 				{
-					while(superGenome[i + l] == superGenome[phi[i] + l])
-					{
-						++l;
-					}
-
-					phi[i] = l;
-					l = std::max(l - 1, 0);
+					++l;
 				}
 
-				saidx_t pos;
-				for(size_t i = 0; i < superGenome.size(); i++)
+				phi[i] = static_cast<saidx_t>(l);
+				l = l > 0 ? l - 1 : 0;
+			}
+
+			saidx_t pos;
+			extension.Assign(superGenome.size());
+			for(size_t i = 0; i < superGenome.size(); i++)
+			{
+				posFile->Read(&pos, sizeof(pos), 1);
+				if(static_cast<size_t>(phi[pos]) >= k)
 				{
-					posFile->Read(&pos, sizeof(pos), 1);
-					saidx_t lcp = phi[pos];
-					lcpFile->Write(&lcp, sizeof(lcp), 1);
+					extension.Set(i);
 				}
 			}
-			
-			lcpFile->Rewind();
-			lcp.assign(superGenome.size(), 0);
-			lcpFile->Read(&lcp[0], sizeof(lcp[0]), lcp.size());			
+
 			posFile->Rewind();
 			return posFile;
-		}		
+		}
 	}
 
-	size_t IndexedSequence::EnumerateBifurcationsSArray(const std::vector<std::string> & data, const std::string & tempDir, std::vector<BifurcationInstance> & positiveBif, std::vector<BifurcationInstance> & negativeBif)
+	size_t IndexedSequence::EnumerateBifurcationsSArray(const std::vector<std::string> & data, const std::string & tempDir, std::vector<BifurcationInstance> & positiveBif, std::vector<BifurcationInstance> & negativeBif, Workspace * workspace)
 	{
 		positiveBif.clear();
 		negativeBif.clear();
 		Size bifurcationCount = 0;
 		std::vector<size_t> cumSize;
-		std::string superGenome(1, SEPARATION_CHAR);
+		Workspace local;
+		std::string & superGenome = (workspace != 0 ? *workspace : local).superGenome;
+		superGenome.assign(1, SEPARATION_CHAR);
 		for(size_t chr = 0; chr < data.size(); chr++)
 		{
 			cumSize.push_back(superGenome.size());
@@ -183,9 +327,10 @@ namespace SyntenyFinder
 		}
 		
 		std::vector<saidx_t> pos;
-		std::vector<saidx_t> lcp;
+		BitVector extension;
 		CreateOutDirectory(tempDir);
-		FilePtr posFile = CalculateLCP(superGenome, lcp, tempDir);
+		FilePtr posFile = CalculateExtensionBits(superGenome, k_, extension, tempDir);
+		PhaseTimer timer("bifurcation_enumeration");
 		CharSet prev;
 		CharSet next;
 		std::vector<BifurcationInstance> * ret[] = {&positiveBif, &negativeBif};
@@ -209,7 +354,7 @@ namespace SyntenyFinder
 				{
 					pos.push_back(saidx_t());
 					posFile->Read(&pos.back(), sizeof(pos[0]), 1);
-					assert(lcp[start + match] == StupidLCP(superGenome, pos[match], pos[match - 1]));
+					assert(extension.Get(start + match) == (StupidLCP(superGenome, pos[match], pos[match - 1]) >= k_));
 				}
 
 				if(pos[match] > 0)
@@ -222,7 +367,7 @@ namespace SyntenyFinder
 					next.Add(superGenome[pos[match] + k_]);
 				}
 			}
-			while(++match + start < superGenome.size() && lcp[match + start] >= static_cast<size_t>(k_));
+			while(++match + start < superGenome.size() && extension.Get(match + start));
 
 			if(Bifurcation(prev) || Bifurcation(next))
 			{
@@ -260,13 +405,16 @@ namespace SyntenyFinder
 		return bifurcationCount;
 	}
 
-	size_t IndexedSequence::EnumerateBifurcationsSArrayInRAM(const std::vector<std::string> & data, std::vector<BifurcationInstance> & positiveBif, std::vector<BifurcationInstance> & negativeBif)
+	size_t IndexedSequence::EnumerateBifurcationsSArrayInRAM(const std::vector<std::string> & data, std::vector<BifurcationInstance> & positiveBif, std::vector<BifurcationInstance> & negativeBif, Workspace * workspace)
 	{
 		positiveBif.clear();
 		negativeBif.clear();
 		Size bifurcationCount = 0;
 		std::vector<size_t> cumSize;
-		std::string superGenome(1, SEPARATION_CHAR);
+		Workspace local;
+		Workspace & buffer = workspace != 0 ? *workspace : local;
+		std::string & superGenome = buffer.superGenome;
+		superGenome.assign(1, SEPARATION_CHAR);
 		for(size_t chr = 0; chr < data.size(); chr++)
 		{
 			cumSize.push_back(superGenome.size());
@@ -285,81 +433,323 @@ namespace SyntenyFinder
 			Flank(superGenome, superGenome.size() - 1 - data[chr].size(), superGenome.size() - 1, k_, SEPARATION_CHAR);
 		}
 
-		std::vector<Size> lcp;
-		std::vector<saidx_t> order(superGenome.size());
+		BitVector & extension = buffer.extension;
+		std::vector<saidx_t> & order = buffer.order;
+		order.resize(superGenome.size());
 		{
-			std::vector<saidx_t> pos(superGenome.size());
-			divsufsort(reinterpret_cast<const sauchar_t*>(superGenome.c_str()), &order[0], static_cast<saidx_t>(order.size()));
+			std::vector<saidx_t> & pos = buffer.pos;
+			pos.resize(superGenome.size());
+			{
+				PhaseTimer timer("suffix_array");
+				divsufsort(reinterpret_cast<const sauchar_t*>(superGenome.c_str()), &order[0], static_cast<saidx_t>(order.size()));
+			}
+
+			PhaseTimer timer("lcp");
 			for(size_t i = 0; i < order.size(); i++)
 			{
 				pos[order[i]] = static_cast<saidx_t>(i);
 			}
 
-			GetHeight(superGenome, order, pos, lcp);	
+			GetExtensionBits(superGenome, order, pos, k_, extension);
+			//The scan does not need the inverse suffix array
+			std::vector<saidx_t>().swap(pos);
+		}
+
+		//The suffix array is split into ranges at the starts of the k-mer intervals,
+		//each thread numbers the bifurcations of its range from zero, then the numbers
+		//are shifted by the counts of the previous ranges, as if the scan was serial
+		PhaseTimer timer("bifurcation_enumeration");
+		int chunks = static_cast<int>(std::max<size_t>(1, std::min(GetThreadsNumber(), superGenome.size() / MIN_SCAN_CHUNK_SIZE)));
+		std::vector<size_t> bound(chunks + 1, superGenome.size());
+		for(int chunk = 0; chunk < chunks; chunk++)
+		{
+			bound[chunk] = chunk == 0 ? 0 : std::max(bound[chunk - 1], extension.NextClear(superGenome.size() * chunk / chunks));
+		}
+
+		std::vector<Size> count(chunks + 1, 0);
+		std::vector<std::vector<BifurcationInstance> > chunkBif(chunks * 2);
+		#pragma omp parallel for schedule(static, 1)
+		for(int chunk = 0; chunk < chunks; chunk++)
+		{
+			CharSet prev;
+			CharSet next;
+			std::vector<BifurcationInstance> * ret[] = {&chunkBif[chunk * 2], &chunkBif[chunk * 2 + 1]};
+			std::vector<std::pair<DNASequence::Direction, BifurcationInstance> > candidate;
+			for(size_t start = bound[chunk]; start < bound[chunk + 1]; )
+			{
+				if(superGenome[order[start]] == SEPARATION_CHAR  || !IsDefiniteBase(superGenome[order[start]]))
+				{
+					start++;
+					continue;
+				}
+
+				prev.Clear();
+				next.Clear();
+				size_t end = extension.NextClear(start + 1);
+				for(size_t i = start; i < end; i++)
+				{
+					if(order[i] > 0)
+					{
+						prev.Add(superGenome[order[i] - 1]);
+					}
+
+					if(order[i] + k_ < superGenome.size())
+					{
+						next.Add(superGenome[order[i] + k_]);
+					}
+				}
+
+				if(Bifurcation(prev) || Bifurcation(next))
+				{
+					candidate.clear();
+					bool terminal = false;
+					for(size_t i = start; i < end; i++)
+					{
+						size_t suffix = order[i];
+						size_t chr = std::upper_bound(cumSize.begin(), cumSize.end(), suffix) - cumSize.begin() - 1;
+						DNASequence::Direction strand = chr < data.size() ? DNASequence::positive : DNASequence::negative;
+						size_t pos = suffix - cumSize[chr];
+						chr = chr < data.size() ? chr : chr - data.size();
+						if(pos + k_ <= data[chr].size())
+						{
+							terminal = terminal || superGenome[suffix - 1] == SEPARATION_CHAR || superGenome[suffix + k_] == SEPARATION_CHAR;
+							candidate.push_back(std::make_pair(strand, BifurcationInstance(count[chunk + 1], static_cast<Size>(chr), static_cast<Size>(pos))));
+						}
+					}
+
+					if(candidate.size() > 1 || terminal)
+					{
+						count[chunk + 1]++;
+						for(size_t i = 0; i < candidate.size(); i++)
+						{
+							ret[candidate[i].first == DNASequence::positive ? 0 : 1]->push_back(candidate[i].second);
+						}
+					}
+				}
+				
+				start = end;
+			}
+		}
+
+		for(int chunk = 0; chunk < chunks; chunk++)
+		{
+			count[chunk + 1] += count[chunk];
+		}
+
+		bifurcationCount = count[chunks];
+		std::vector<BifurcationInstance> * ret[] = {&positiveBif, &negativeBif};
+		for(size_t strand = 0; strand < 2; strand++)
+		{
+			size_t size = 0;
+			for(int chunk = 0; chunk < chunks; chunk++)
+			{
+				size += chunkBif[chunk * 2 + strand].size();
+			}
+
+			ret[strand]->resize(size);
+		}
+
+		#pragma omp parallel for schedule(static, 1)
+		for(int chunk = 0; chunk < chunks * 2; chunk++)
+		{
+			size_t strand = chunk % 2;
+			size_t shift = 0;
+			for(int prevChunk = strand; prevChunk < chunk; prevChunk += 2)
+			{
+				shift += chunkBif[prevChunk].size();
+			}
+
+			for(size_t i = 0; i < chunkBif[chunk].size(); i++)
+			{
+				BifurcationInstance & bif = chunkBif[chunk][i];
+				(*ret[strand])[shift + i] = BifurcationInstance(bif.bifId + count[chunk / 2], bif.chr, bif.pos);
+			}
+		}
+
+		std::vector<std::vector<BifurcationInstance> >().swap(chunkBif);
+		ParallelSort(positiveBif);
+		ParallelSort(negativeBif);
+		return bifurcationCount;
+	}
+
+	//The suffix array is built for the positive strand only, so the index takes about
+	//half of the memory. The occurrences of a k-mer on the negative strand are the
+	//occurrences of its reverse complement, the interval of the reverse complement is
+	//followed along the chromosome with the backward search on the BWT. The identifiers
+	//are the same as the suffix array of both strands gives.
+	size_t IndexedSequence::EnumerateBifurcationsFM(const std::vector<std::string> & data, std::vector<BifurcationInstance> & positiveBif, std::vector<BifurcationInstance> & negativeBif, Workspace * workspace)
+	{
+		positiveBif.clear();
+		negativeBif.clear();
+		const saidx_t NO_INTERVAL = -1;
+		std::vector<size_t> cumSize;
+		Workspace local;
+		Workspace & buffer = workspace != 0 ? *workspace : local;
+		std::string & text = buffer.superGenome;
+		text.assign(1, SEPARATION_CHAR);
+		for(size_t chr = 0; chr < data.size(); chr++)
+		{
+			cumSize.push_back(text.size());
+			text += data[chr];
+			text += SEPARATION_CHAR;
+		}
+
+		BitVector & extension = buffer.extension;
+		std::vector<saidx_t> & order = buffer.order;
+		std::vector<saidx_t> & rank = buffer.pos;
+		order.resize(text.size());
+		rank.resize(text.size());
+		{
+			PhaseTimer timer("suffix_array");
+			divsufsort(reinterpret_cast<const sauchar_t*>(text.c_str()), &order[0], static_cast<saidx_t>(order.size()));
+		}
+
+		{
+			PhaseTimer timer("lcp");
+			for(size_t i = 0; i < order.size(); i++)
+			{
+				rank[order[i]] = static_cast<saidx_t>(i);
+			}
+
+			GetExtensionBits(text, order, rank, k_, extension);
+		}
+
+		//The inverse suffix array is not needed anymore, its memory keeps the start
+		//of the interval of the reverse complement of each k-mer
+		std::vector<saidx_t> & reverseStart = rank;
+		{
+			PhaseTimer timer("fm_index");
+			FMIndex index(text, order);
+			for(size_t chr = 0; chr < data.size(); chr++)
+			{
+				bool found = false;
+				size_t start = 0;
+				size_t end = 0;
+				size_t covered = 0;
+				const char * str = &text[cumSize[chr]];
+				for(size_t i = 0; i + k_ <= data[chr].size(); i++)
+				{
+					//The interval of the previous (k + 1)-mer is widened to its k-prefix
+					if(found && index.Extend(start, end, Complement(str[i + k_ - 1])))
+					{
+						start = extension.PrevClear(start);
+						end = extension.NextClear(end);
+					}
+					else if(i < covered)
+					{
+						found = false;
+					}
+					else
+					{
+						//If the reverse complement of the last chars of the k-mer does not
+						//occur, neither do the k-mers up to the probe, so the full search
+						//is skipped for them
+						found = true;
+						if(k_ > PROBE_SIZE)
+						{
+							size_t probe = i + k_ - PROBE_SIZE;
+							start = 0;
+							end = text.size();
+							for(size_t j = probe; j < i + k_ && found; j++)
+							{
+								found = index.Extend(start, end, Complement(str[j]));
+							}
+
+							covered = found ? covered : probe + 1;
+						}
+
+						start = 0;
+						end = text.size();
+						for(size_t j = 0; j < k_ && found; j++)
+						{
+							found = index.Extend(start, end, Complement(str[i + j]));
+						}
+					}
+
+					reverseStart[cumSize[chr] + i] = found ? static_cast<saidx_t>(start) : NO_INTERVAL;
+				}
+			}
 		}
 
+		PhaseTimer timer("bifurcation_enumeration");
 		CharSet prev;
 		CharSet next;
-		std::vector<BifurcationInstance> * ret[] = {&positiveBif, &negativeBif};
-		std::vector<std::pair<DNASequence::Direction, BifurcationInstance> > candidate;
-		for(size_t start = 0; start < superGenome.size(); )
+		std::vector<KMerRef> kmer;
+		std::vector<std::pair<size_t, size_t> > group;
+		for(size_t start = 0; start < text.size(); )
 		{
-			if(superGenome[order[start]] == SEPARATION_CHAR  || !IsDefiniteBase(superGenome[order[start]]))
+			size_t end = extension.NextClear(start + 1);
+			size_t suffix = order[start];
+			size_t chr = std::upper_bound(cumSize.begin(), cumSize.end(), suffix) - cumSize.begin() - 1;
+			if(text[suffix] == SEPARATION_CHAR || suffix - cumSize[chr] + k_ > data[chr].size())
 			{
-				start++;
+				start = end;
 				continue;
 			}
 
 			prev.Clear();
 			next.Clear();
-			size_t end = start;
-			do
+			for(size_t i = start; i < end; i++)
 			{
-				if(order[end] > 0)
-				{
-					prev.Add(superGenome[order[end] - 1]);
-				}
+				prev.Add(text[order[i] - 1]);
+				next.Add(text[order[i] + k_]);
+			}
 
-				if(order[end] + k_ < superGenome.size())
+			saidx_t reverse = reverseStart[suffix];
+			if(reverse != NO_INTERVAL)
+			{
+				for(size_t i = reverse, reverseEnd = extension.NextClear(reverse + 1); i < reverseEnd; i++)
 				{
-					next.Add(superGenome[order[end] + k_]);
+					prev.Add(Complement(text[order[i] + k_]));
+					next.Add(Complement(text[order[i] - 1]));
 				}
 			}
-			while(++end < superGenome.size() && lcp[end] >= k_);
 
 			if(Bifurcation(prev) || Bifurcation(next))
 			{
-				candidate.clear();
-				bool terminal = false;
-				for(size_t i = start; i < end; i++)
+				kmer.push_back(KMerRef(suffix, false, group.size()));
+				if(reverse == NO_INTERVAL)
 				{
-					size_t suffix = order[i];
-					size_t chr = std::upper_bound(cumSize.begin(), cumSize.end(), suffix) - cumSize.begin() - 1;
-					DNASequence::Direction strand = chr < data.size() ? DNASequence::positive : DNASequence::negative;
-					size_t pos = suffix - cumSize[chr];
-					chr = chr < data.size() ? chr : chr - data.size();
-					if(pos + k_ <= data[chr].size())
-					{
-						terminal = terminal || superGenome[suffix - 1] == SEPARATION_CHAR || superGenome[suffix + k_] == SEPARATION_CHAR;
-						candidate.push_back(std::make_pair(strand, BifurcationInstance(bifurcationCount, static_cast<Size>(chr), static_cast<Size>(pos))));
-					}
+					kmer.push_back(KMerRef(suffix, true, group.size()));
 				}
 
-				if(candidate.size() > 1 || terminal)
-				{
-					bifurcationCount++;
-					for(size_t i = 0; i < candidate.size(); i++)
-					{
-						ret[candidate[i].first == DNASequence::positive ? 0 : 1]->push_back(candidate[i].second);
-					}
-				}
+				group.push_back(std::make_pair(start, end));
 			}
-			
+
 			start = end;
 		}
-		
-		std::sort(positiveBif.begin(), positiveBif.end());
-		std::sort(negativeBif.begin(), negativeBif.end());
-		return bifurcationCount;
+
+		//The reverse complement of a bifurcation is a bifurcation, so it is either a group
+		//itself or is numbered beside the group it complements
+		std::sort(kmer.begin(), kmer.end(), KMerLess(text, k_));
+		std::vector<Size> id(group.size() * 2);
+		for(size_t i = 0; i < kmer.size(); i++)
+		{
+			id[kmer[i].owner * 2 + (kmer[i].reverse ? 1 : 0)] = static_cast<Size>(i);
+		}
+
+		for(size_t i = 0; i < group.size(); i++)
+		{
+			saidx_t reverse = reverseStart[order[group[i].first]];
+			if(reverse != NO_INTERVAL)
+			{
+				size_t reverseGroup = std::lower_bound(group.begin(), group.end(), std::make_pair(static_cast<size_t>(reverse), size_t(0))) - group.begin();
+				assert(reverseGroup < group.size() && group[reverseGroup].first == static_cast<size_t>(reverse));
+				id[i * 2 + 1] = id[reverseGroup * 2];
+			}
+
+			for(size_t j = group[i].first; j < group[i].second; j++)
+			{
+				size_t suffix = order[j];
+				size_t chr = std::upper_bound(cumSize.begin(), cumSize.end(), suffix) - cumSize.begin() - 1;
+				size_t pos = suffix - cumSize[chr];
+				positiveBif.push_back(BifurcationInstance(id[i * 2], static_cast<Size>(chr), static_cast<Size>(pos)));
+				negativeBif.push_back(BifurcationInstance(id[i * 2 + 1], static_cast<Size>(chr), static_cast<Size>(data[chr].size() - pos - k_)));
+			}
+		}
+
+		ParallelSort(positiveBif);
+		ParallelSort(negativeBif);
+		return kmer.size();
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,33 @@
+//****************************************************************************
+//* Copyright (c) 2012 Saint-Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//****************************************************************************
+
+#ifndef _WORKSPACE_H_
+#define _WORKSPACE_H_
+
+#include "bitvector.h"
+#include "scratch.h"
+
+namespace SyntenyFinder
+{
+	//Buffers of the vertex enumeration and the bulge removal kept between the
+	//jobs run by one worker, so consecutive jobs reuse the memory instead of
+	//allocating it again. A workspace may be used by only one job at a time.
+	class Workspace
+	{
+	public:
+		Workspace() {}
+		std::string superGenome;
+		std::vector<saidx_t> order;
+		std::vector<saidx_t> pos;
+		BitVector extension;
+		//Temporaries of the bulge removal
+		ScratchArena scratch;
+	private:
+		DISALLOW_COPY_AND_ASSIGN(Workspace);
+	};
+}
+
+#endif